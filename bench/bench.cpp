@@ -0,0 +1,134 @@
+#include "bench.hpp"
+#include "fmt/core.h"
+#include "jobs.hpp"
+#include "meteor-shapes.hpp"
+#include "random.hpp"
+#include "platform.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+
+// ALLOCATIONS
+// Workers run parts of the systems, every thread counts
+
+static std::atomic<size_t> s_allocatedBytes{0};
+static std::atomic<size_t> s_allocations{0};
+
+void *operator new(size_t size) {
+  s_allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+  s_allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void *ptr = std::malloc(size ? size : 1)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+void *operator new[](size_t size) { return operator new(size); }
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { std::free(ptr); }
+
+namespace Bench {
+
+size_t AllocatedBytes() { return s_allocatedBytes; }
+size_t Allocations() { return s_allocations; }
+
+} // namespace Bench
+
+// OUTPUT
+
+static void PrintTable(const std::vector<Bench::Result> &results) {
+  fmt::print("{:<40} {:>9} {:>14} {:>12} {:>10}\n", "benchmark", "n", "ns/op", "bytes/op",
+             "allocs/op");
+  for (const auto &result : results) {
+    fmt::print("{:<40} {:>9} {:>14.2f} {:>12.2f} {:>10.3f}\n", result.name, result.n,
+               result.ns_per_op, result.bytes_per_op, result.allocs_per_op);
+  }
+}
+
+static void PrintCsv(const std::vector<Bench::Result> &results) {
+  fmt::print("benchmark,n,ns_per_op,bytes_per_op,allocs_per_op\n");
+  for (const auto &result : results) {
+    fmt::print("{},{},{:.3f},{:.3f},{:.4f}\n", result.name, result.n, result.ns_per_op,
+               result.bytes_per_op, result.allocs_per_op);
+  }
+}
+
+// Names never contain quotes or backslashes, nothing to escape
+static void PrintJson(const std::vector<Bench::Result> &results) {
+  fmt::print("[\n");
+  for (size_t i = 0; i < results.size(); i++) {
+    const auto &result = results[i];
+    fmt::print("  {{\"benchmark\": \"{}\", \"n\": {}, \"ns_per_op\": {:.3f}, "
+               "\"bytes_per_op\": {:.3f}, \"allocs_per_op\": {:.4f}}}{}\n",
+               result.name, result.n, result.ns_per_op, result.bytes_per_op,
+               result.allocs_per_op, i + 1 < results.size() ? "," : "");
+  }
+  fmt::print("]\n");
+}
+
+// minoids_bench [--max <entities>] [--systems-max <meteors>] [--suite all|micro|systems]
+//               [--format table|csv|json] [--workers <count>, 0 runs the systems on one core]
+int main(int argc, char **argv) {
+  size_t max = 1'000'000;
+  size_t systems_max = 100'000; // a frame of the full systems takes seconds past that
+  const char *suite = "all";
+  const char *format = "table";
+  int workers = -1;
+  for (int i = 1; i + 1 < argc; i++) {
+    if (strcmp(argv[i], "--max") == 0) {
+      max = strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "--systems-max") == 0) {
+      systems_max = strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "--suite") == 0) {
+      suite = argv[++i];
+    } else if (strcmp(argv[i], "--format") == 0) {
+      format = argv[++i];
+    } else if (strcmp(argv[i], "--workers") == 0) {
+      workers = atoi(argv[++i]);
+    }
+  }
+
+  std::vector<size_t> sizes;
+  for (size_t n = 1'000; n <= max; n *= 10) {
+    sizes.push_back(n);
+  }
+
+  // 1-2-5 steps, enough points for a scaling curve
+  std::vector<size_t> systems_sizes;
+  for (size_t decade = 1'000; decade <= systems_max; decade *= 10) {
+    for (const size_t step : {1, 2, 5}) {
+      if (decade * step <= systems_max) {
+        systems_sizes.push_back(decade * step);
+      }
+    }
+  }
+
+  Jobs::Init(workers);
+  // Components that load textures must not need a window
+  Platform::Set(std::make_unique<Platform::NullBackend>(1.f / 60.f));
+  // Same draws and meteor shapes every run
+  Random::Seed(1);
+  MeteorShapes::Generate(1);
+
+  std::vector<Bench::Result> results;
+  if (strcmp(suite, "all") == 0 || strcmp(suite, "micro") == 0) {
+    Bench::Micro(results, sizes);
+  }
+  if (strcmp(suite, "all") == 0 || strcmp(suite, "systems") == 0) {
+    Bench::Systems(results, systems_sizes);
+  }
+
+  if (strcmp(format, "csv") == 0) {
+    PrintCsv(results);
+  } else if (strcmp(format, "json") == 0) {
+    PrintJson(results);
+  } else {
+    PrintTable(results);
+  }
+
+  Jobs::Shutdown();
+  return 0;
+}
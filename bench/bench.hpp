@@ -0,0 +1,74 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Bench {
+
+struct Result {
+  std::string name;
+  size_t n;            // entities in the world
+  double ns_per_op;    // fastest repetition
+  double bytes_per_op; // through the global operator new
+  double allocs_per_op;
+};
+
+// Counted by the operator new replacement in bench.cpp
+size_t AllocatedBytes();
+size_t Allocations();
+
+// Keeps the optimizer from dropping a result nobody reads
+template <typename T> inline void DoNotOptimize(const T &value) {
+#if defined(_MSC_VER)
+  static const void *volatile s_sink;
+  s_sink = &value;
+#else
+  asm volatile("" : : "g"(&value) : "memory");
+#endif
+}
+
+constexpr int MIN_REPETITIONS = 3;
+constexpr double MIN_SECONDS = .05; // budget per benchmark, setup included
+
+// Times `body`, which performs `ops` operations on a world of `n` entities.
+// `setup` runs before every repetition and is neither timed nor counted.
+template <typename Setup, typename Body>
+Result Run(std::string name, size_t n, size_t ops, Setup &&setup, Body &&body) {
+  using Clock = std::chrono::steady_clock;
+
+  double best = 0.;
+  size_t bytes = 0;
+  size_t allocs = 0;
+  const auto begin = Clock::now();
+  for (int rep = 0;
+       rep < MIN_REPETITIONS ||
+       std::chrono::duration<double>(Clock::now() - begin).count() < MIN_SECONDS;
+       rep++) {
+    setup();
+    const size_t bytes_before = AllocatedBytes();
+    const size_t allocs_before = Allocations();
+    const auto start = Clock::now();
+    body();
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    bytes = AllocatedBytes() - bytes_before;
+    allocs = Allocations() - allocs_before;
+
+    best = rep == 0 ? seconds : std::min(best, seconds);
+  }
+
+  const double count = ops > 0 ? static_cast<double>(ops) : 1.;
+  return {std::move(name), n, best * 1e9 / count, bytes / count, allocs / count};
+}
+
+// SUITES
+void Micro(std::vector<Result> &results, const std::vector<size_t> &sizes);
+void Systems(std::vector<Result> &results, const std::vector<size_t> &sizes);
+
+} // namespace Bench
+
+#endif
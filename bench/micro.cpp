@@ -0,0 +1,270 @@
+#include "bench.hpp"
+#include "FastNoiseLite.h"
+#include "ecs.hpp"
+#include "fmt/core.h"
+#include "sparse-set.hpp"
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <utility>
+
+using namespace ECS;
+
+namespace Bench {
+
+static constexpr size_t DELETE_SAMPLE = 1'000; // DeleteEntity is linear in the entity count
+static constexpr unsigned SEED = 23;
+
+static std::vector<size_t> Shuffled(size_t n) {
+  std::vector<size_t> ids(n);
+  std::iota(ids.begin(), ids.end(), 0);
+  std::shuffle(ids.begin(), ids.end(), std::mt19937(SEED));
+  return ids;
+}
+
+// SPARSE SET
+
+static void SparseSetOps(std::vector<Result> &results, size_t n) {
+  const auto shuffled = Shuffled(n);
+  // SparseSet is not assignable, every repetition starts from a new one
+  std::unique_ptr<SparseSet<PositionComponent>> positions;
+  std::unique_ptr<SparseSet<VelocityComponent>> velocities;
+
+  auto fill = [&] {
+    positions = std::make_unique<SparseSet<PositionComponent>>(n);
+    for (size_t id = 0; id < n; id++) {
+      positions->Add(id, PositionComponent(id, id));
+    }
+  };
+
+  results.push_back(Run(
+      "SparseSet::Add", n, n,
+      [&] { positions = std::make_unique<SparseSet<PositionComponent>>(n); },
+      [&] {
+        for (size_t id = 0; id < n; id++) {
+          positions->Add(id, PositionComponent(id, id));
+        }
+      }));
+
+  results.push_back(Run(
+      "SparseSet::Add (growing)", n, n,
+      [&] { positions = std::make_unique<SparseSet<PositionComponent>>(); },
+      [&] {
+        for (size_t id = 0; id < n; id++) {
+          positions->Add(id, PositionComponent(id, id));
+        }
+      }));
+
+  fill();
+  results.push_back(Run(
+      "SparseSet::Get", n, n, [] {},
+      [&] {
+        float sum = 0.f;
+        for (size_t id = 0; id < n; id++) {
+          sum += positions->Get(id)->value.x;
+        }
+        DoNotOptimize(sum);
+      }));
+
+  results.push_back(Run(
+      "SparseSet::Get (random)", n, n, [] {},
+      [&] {
+        float sum = 0.f;
+        for (const size_t id : shuffled) {
+          sum += positions->Get(id)->value.x;
+        }
+        DoNotOptimize(sum);
+      }));
+
+  // Half of the queries miss
+  results.push_back(Run(
+      "SparseSet::contains", n, 2 * n, [] {},
+      [&] {
+        size_t found = 0;
+        for (size_t id = 0; id < 2 * n; id++) {
+          found += positions->contains(id);
+        }
+        DoNotOptimize(found);
+      }));
+
+  results.push_back(Run("SparseSet::Remove (random)", n, n, fill, [&] {
+    for (const size_t id : shuffled) {
+      positions->Remove(id);
+    }
+  }));
+
+  fill();
+  results.push_back(Run(
+      "SparseSet iterate", n, n, [] {},
+      [&] {
+        float sum = 0.f;
+        for (const auto &pos : positions->dense) {
+          sum += pos.value.x;
+        }
+        DoNotOptimize(sum);
+      }));
+
+  // PositionSystem access pattern: walk one pool, look the other one up
+  velocities = std::make_unique<SparseSet<VelocityComponent>>(n);
+  for (const size_t id : shuffled) {
+    velocities->Add(id, VelocityComponent(1.f, 1.f));
+  }
+  results.push_back(Run(
+      "SparseSet iterate joined", n, n, [] {},
+      [&] {
+        for (const auto &vel : velocities->dense) {
+          auto pos = positions->Get(vel.entity);
+          pos->value.x += vel.value.x;
+          pos->value.y += vel.value.y;
+        }
+        DoNotOptimize(positions->dense.data());
+      }));
+}
+
+// NOISE
+
+static constexpr int NOISE_GRID_WIDTH = 64;
+
+// n samples of a NOISE_GRID_WIDTH wide grid, scalar GetNoise against the batch API
+static void NoiseOps(std::vector<Result> &results, size_t n) {
+  const int height = static_cast<int>((n + NOISE_GRID_WIDTH - 1) / NOISE_GRID_WIDTH);
+  const size_t samples = static_cast<size_t>(height) * NOISE_GRID_WIDTH;
+  std::vector<float> out(samples);
+
+  const std::pair<const char *, FastNoiseLite::NoiseType> types[] = {
+      {"Perlin", FastNoiseLite::NoiseType_Perlin},
+      {"OpenSimplex2", FastNoiseLite::NoiseType_OpenSimplex2}};
+  for (const auto &[name, type] : types) {
+    FastNoiseLite noise(SEED);
+    noise.SetNoiseType(type);
+    noise.SetFrequency(.1f);
+
+    results.push_back(Run(
+        fmt::format("GetNoise ({})", name), n, samples, [] {},
+        [&] {
+          for (int row = 0; row < height; row++) {
+            for (int col = 0; col < NOISE_GRID_WIDTH; col++) {
+              out[row * NOISE_GRID_WIDTH + col] = noise.GetNoise(float(col), float(row));
+            }
+          }
+          DoNotOptimize(out.data());
+        }));
+
+    results.push_back(Run(
+        fmt::format("GetNoiseGrid ({})", name), n, samples, [] {},
+        [&] {
+          noise.GetNoiseGrid(0.f, 0.f, 1.f, NOISE_GRID_WIDTH, height, out.data());
+          DoNotOptimize(out.data());
+        }));
+  }
+}
+
+// REGISTRY
+
+// Fresh registry with entity ids starting from 0
+static std::unique_ptr<Registry> MakeRegistry(size_t n, std::vector<Entity> &entities) {
+  ThreadSafeIdGenerator::reset();
+  auto registry = std::make_unique<Registry>();
+  registry->Init();
+  entities.clear();
+  for (size_t i = 0; i < n; i++) {
+    entities.push_back(registry->CreateEntity());
+  }
+  return registry;
+}
+
+static void RegistryOps(std::vector<Result> &results, size_t n) {
+  std::unique_ptr<Registry> registry;
+  std::vector<Entity> entities;
+
+  results.push_back(Run(
+      "Registry::CreateEntity", n, n,
+      [&] {
+        registry.reset();
+        registry = MakeRegistry(0, entities);
+      },
+      [&] {
+        for (size_t i = 0; i < n; i++) {
+          DoNotOptimize(registry->CreateEntity());
+        }
+      }));
+
+  const size_t sample = std::min(n, DELETE_SAMPLE);
+  results.push_back(Run(
+      "Registry::DeleteEntity", n, sample,
+      [&] {
+        registry.reset();
+        registry = MakeRegistry(n, entities);
+        for (const Entity entity : entities) {
+          registry->Add<PositionComponent>(entity, 0.f, 0.f);
+          registry->Add<VelocityComponent>(entity, 0.f, 0.f);
+        }
+      },
+      [&] {
+        for (size_t i = 0; i < sample; i++) {
+          registry->DeleteEntity(entities[i * (n / sample)]);
+        }
+      }));
+}
+
+template <typename T, typename... Args>
+static void ComponentOps(std::vector<Result> &results, size_t n, const char *name,
+                         const Args &...args) {
+  std::unique_ptr<Registry> registry;
+  std::vector<Entity> entities;
+
+  results.push_back(Run(
+      fmt::format("Registry::Add<{}>", name), n, n,
+      [&] {
+        registry.reset();
+        registry = MakeRegistry(n, entities);
+      },
+      [&] {
+        for (const Entity entity : entities) {
+          registry->Add<T>(entity, args...);
+        }
+      }));
+
+  results.push_back(Run(
+      fmt::format("Registry::Get<{}>", name), n, n, [] {},
+      [&] {
+        size_t found = 0;
+        for (const Entity entity : entities) {
+          found += registry->Get<T>(entity) != nullptr;
+        }
+        DoNotOptimize(found);
+      }));
+}
+
+void Micro(std::vector<Result> &results, const std::vector<size_t> &sizes) {
+  for (const size_t n : sizes) {
+    SparseSetOps(results, n);
+    RegistryOps(results, n);
+    NoiseOps(results, n);
+
+    ComponentOps<PositionComponent>(results, n, "Position", 1.f, 1.f);
+    ComponentOps<VelocityComponent>(results, n, "Velocity", 1.f, 1.f);
+    ComponentOps<ColliderComponent>(results, n, "Collider", 10.f, CollisionLayer::METEOR,
+                                    CollisionLayer::METEOR_MASK);
+    ComponentOps<TextComponent>(results, n, "Text", "bench");
+    ComponentOps<ForceComponent>(results, n, "Force", 1.f, 1.f);
+    ComponentOps<RenderComponent>(results, n, "Render", Layer::GROUND, Shape::CIRCLE, BLACK,
+                                  10.f);
+    ComponentOps<RenderComponent>(results, n, "Render meteor", Layer::GROUND, Shape::METEOR,
+                                  BLACK, 10.f, 8.f, MeteorShapes::Handle(0));
+    ComponentOps<SpriteComponent>(results, n, "Sprite", Layer::SKY, std::string("bench.png"));
+    ComponentOps<UIComponent>(results, n, "UI", UIElement::BAR);
+    ComponentOps<HealthComponent>(results, n, "Health", 1.f);
+    ComponentOps<DmgComponent>(results, n, "Dmg", 1.f);
+    ComponentOps<GameStateComponent>(results, n, "GameState", GameStateValue(1));
+    ComponentOps<WeaponComponent>(results, n, "Weapon", Entity(0), 10.f);
+    ComponentOps<InputComponent>(results, n, "Input", 1.f, 10.f);
+    ComponentOps<EmitterComponent>(results, n, "Emitter", 1, 10, Shape::CIRCLE,
+                                   Vector2{1.f, 1.f});
+    ComponentOps<ParticleComponent>(results, n, "Particle", Entity(0));
+    ComponentOps<BodyComponent>(results, n, "Body", 1.f);
+  }
+}
+
+} // namespace Bench
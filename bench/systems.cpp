@@ -0,0 +1,153 @@
+#include "bench.hpp"
+#include "ecs.hpp"
+#include "platform.hpp"
+#include <cmath>
+#include <memory>
+#include <random>
+
+using namespace ECS;
+
+namespace Bench {
+
+// Synthetic world for N meteors: N particles and N / 10 ship-like colliders that hit them.
+// The world grows with the entity count so the density, and with it the number of touching
+// pairs per entity, stays the same for every N.
+struct World {
+  size_t meteors;
+  size_t particles;
+  size_t colliders;
+};
+
+static constexpr float AREA_PER_ENTITY = 100.f * 100.f;
+static constexpr float MIN_METEOR_SIZE = 10.f;
+static constexpr float MAX_METEOR_SIZE = 30.f;
+static constexpr float METEOR_NOISE_AMPLITUDE = 8.1f; // as in scene-game.cpp
+static constexpr float MAX_VELOCITY = 1.f;
+static constexpr size_t PARTICLE_LIFETIME = 60; // frames
+static constexpr unsigned SEED = 23;
+
+static std::unique_ptr<Registry> BuildWorld(const World &world) {
+  const size_t count = world.meteors + world.particles + world.colliders;
+  const int side = static_cast<int>(std::sqrt(count * AREA_PER_ENTITY));
+  // PositionSystem wraps at the screen edges
+  Platform::Get().InitWindow(side, side, "minoids_bench");
+
+  ThreadSafeIdGenerator::reset();
+  auto registry = std::make_unique<Registry>();
+  registry->Init();
+
+  std::mt19937 gen(SEED);
+  std::uniform_real_distribution<float> rnd_pos(0.f, side);
+  std::uniform_real_distribution<float> rnd_size(MIN_METEOR_SIZE, MAX_METEOR_SIZE);
+  std::uniform_real_distribution<float> rnd_velocity(-MAX_VELOCITY, MAX_VELOCITY);
+
+  for (size_t i = 0; i < world.meteors; i++) {
+    const float radius = rnd_size(gen);
+    Entity meteor = registry->CreateEntity();
+    registry->Add<PositionComponent>(meteor, rnd_pos(gen), rnd_pos(gen));
+    registry->Add<VelocityComponent>(meteor, rnd_velocity(gen), rnd_velocity(gen));
+    registry->Add<RenderComponent>(meteor, Layer::GROUND, Shape::METEOR, BLACK, radius,
+                                   METEOR_NOISE_AMPLITUDE, MeteorShapes::Handle(i));
+    registry->Add<ColliderComponent>(meteor, Shape::METEOR, radius, METEOR_NOISE_AMPLITUDE,
+                                     CollisionLayer::METEOR, CollisionLayer::METEOR_MASK);
+    registry->Add<BodyComponent>(meteor, .8f);
+    registry->Add<HealthComponent>(meteor, radius);
+    registry->Add<DmgComponent>(meteor, .1f);
+  }
+
+  for (size_t i = 0; i < world.particles; i++) {
+    Entity particle = registry->CreateEntity();
+    registry->Add<PositionComponent>(particle, rnd_pos(gen), rnd_pos(gen));
+    registry->Add<VelocityComponent>(particle, rnd_velocity(gen), rnd_velocity(gen));
+    registry->Add<RenderComponent>(particle, Layer::GROUND, Shape::ELLIPSE, BLACK, 5.f, 5.f);
+    registry->Add<HealthComponent>(particle, i % PARTICLE_LIFETIME + 1.f);
+    registry->Add<ParticleComponent>(particle, Entity(0));
+    // Steady state: every frame one particle in PARTICLE_LIFETIME is removed
+    registry->Get<ParticleComponent>(particle)->active = i % PARTICLE_LIFETIME != 0;
+  }
+
+  for (size_t i = 0; i < world.colliders; i++) {
+    Entity ship = registry->CreateEntity();
+    registry->Add<PositionComponent>(ship, rnd_pos(gen), rnd_pos(gen));
+    registry->Add<VelocityComponent>(ship, rnd_velocity(gen), rnd_velocity(gen));
+    registry->Add<RenderComponent>(ship, Layer::GROUND, Shape::RECTANGLE, BLACK, 60.f, 30.f);
+    registry->Add<ColliderComponent>(ship, 60.f, 30.f, CollisionLayer::SHIP,
+                                     CollisionLayer::SHIP_MASK);
+    registry->Add<HealthComponent>(ship, 10.f);
+    registry->Add<DmgComponent>(ship, .1f);
+  }
+
+  return registry;
+}
+
+// Every repetition starts from the same world and runs one frame of one system, so ns/op is
+// the cost of a frame. The world is rebuilt because the systems consume it: particles die,
+// collisions spawn new ones.
+void Systems(std::vector<Result> &results, const std::vector<size_t> &sizes) {
+  for (const size_t n : sizes) {
+    const World world{n, n, n / 10};
+    std::unique_ptr<Registry> registry;
+    auto build = [&] {
+      registry.reset();
+      registry = BuildWorld(world);
+    };
+
+    results.push_back(Run("PositionSystem", n, 1, build, [&] { registry->PositionSystem(); }));
+
+    // One frame in, so the pair cache holds the previous frame like it does in the game
+    auto warm = [&] {
+      build();
+      registry->CollisionDetectionSystem();
+      registry->PositionSystem();
+    };
+
+    results.push_back(Run("CollisionDetectionSystem", n, 1, warm,
+                          [&] { registry->CollisionDetectionSystem(); }));
+
+    results.push_back(Run(
+        "CollisionResolutionSystem", n, 1,
+        [&] {
+          warm();
+          registry->CollisionDetectionSystem();
+        },
+        [&] { registry->CollisionResolutionSystem(); }));
+
+    // Aging and the deletion of retired particles, as in a game step
+    results.push_back(Run("ParticleSystem", n, 1, build, [&] {
+      registry->ParticleCleanupSystem();
+      registry->ParticleSystem();
+    }));
+
+    // Recording a frame, as the simulation job does, then submitting it to the null backend on
+    // the main thread
+    RenderList list;
+    auto record = [&] {
+      auto &platform = Platform::Get();
+      list.Clear();
+      registry->RenderSystem(list, {static_cast<float>(platform.GetScreenWidth()),
+                                    static_cast<float>(platform.GetScreenHeight())});
+    };
+    results.push_back(Run("RenderSystem", n, 1, build, record));
+    results.push_back(Run(
+        "RenderList::Submit", n, 1,
+        [&] {
+          build();
+          record();
+        },
+        [&] { list.Submit(); }));
+
+    // Both copies warmed up, as after the first frames of the game
+    results.push_back(Run(
+        "CaptureSnapshots", n, 1,
+        [&] {
+          build();
+          for (int copy = 0; copy < 2; copy++) {
+            registry->CaptureSnapshots();
+            registry->SwapSnapshots();
+          }
+        },
+        [&] { registry->CaptureSnapshots(); }));
+  }
+}
+
+} // namespace Bench
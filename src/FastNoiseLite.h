@@ -52,6 +52,90 @@
 
 #include <cmath>
 
+// MINOIDS: GetNoiseBatch / GetNoiseGrid run Perlin and OpenSimplex2 several positions at a time
+// with AVX2 (8 lanes) or SSE2 (4 lanes) when the compiler targets them
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define FNL_BATCH_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FNL_BATCH_SSE2
+#endif
+
+#if defined(FNL_BATCH_AVX2) || defined(FNL_BATCH_SSE2)
+#define FNL_BATCH_SIMD
+namespace FastNoiseLiteBatch
+{
+#if defined(FNL_BATCH_AVX2)
+    static constexpr int WIDTH = 8;
+    using F = __m256;
+    using I = __m256i;
+
+    inline F Load(const float* p) { return _mm256_loadu_ps(p); }
+    inline void Store(float* p, F v) { _mm256_storeu_ps(p, v); }
+    inline F Set(float v) { return _mm256_set1_ps(v); }
+    inline F Lanes() { return _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7); }
+    inline F Add(F a, F b) { return _mm256_add_ps(a, b); }
+    inline F Sub(F a, F b) { return _mm256_sub_ps(a, b); }
+    inline F Mul(F a, F b) { return _mm256_mul_ps(a, b); }
+    inline F Min(F a, F b) { return _mm256_min_ps(a, b); }
+    inline F Greater(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    inline F Select(F mask, F a, F b) { return _mm256_blendv_ps(b, a, mask); }
+
+    inline I SetI(int v) { return _mm256_set1_epi32(v); }
+    inline I AddI(I a, I b) { return _mm256_add_epi32(a, b); }
+    inline I XorI(I a, I b) { return _mm256_xor_si256(a, b); }
+    inline I AndI(I a, I b) { return _mm256_and_si256(a, b); }
+    inline I MulI(I a, I b) { return _mm256_mullo_epi32(a, b); }
+    template <int N> inline I ShiftRightI(I a) { return _mm256_srai_epi32(a, N); }
+    inline I SelectI(F mask, I a, I b) { return _mm256_castps_si256(Select(mask, _mm256_castsi256_ps(a), _mm256_castsi256_ps(b))); }
+    inline F ToFloat(I a) { return _mm256_cvtepi32_ps(a); }
+    // FastFloor: truncate, minus one below zero
+    inline I Floor(F a) { return _mm256_add_epi32(_mm256_cvttps_epi32(a), _mm256_castps_si256(_mm256_cmp_ps(a, _mm256_setzero_ps(), _CMP_LT_OQ))); }
+    inline F Gather(const float* table, I index) { return _mm256_i32gather_ps(table, index, 4); }
+#else
+    static constexpr int WIDTH = 4;
+    using F = __m128;
+    using I = __m128i;
+
+    inline F Load(const float* p) { return _mm_loadu_ps(p); }
+    inline void Store(float* p, F v) { _mm_storeu_ps(p, v); }
+    inline F Set(float v) { return _mm_set1_ps(v); }
+    inline F Lanes() { return _mm_setr_ps(0, 1, 2, 3); }
+    inline F Add(F a, F b) { return _mm_add_ps(a, b); }
+    inline F Sub(F a, F b) { return _mm_sub_ps(a, b); }
+    inline F Mul(F a, F b) { return _mm_mul_ps(a, b); }
+    inline F Min(F a, F b) { return _mm_min_ps(a, b); }
+    inline F Greater(F a, F b) { return _mm_cmpgt_ps(a, b); }
+    inline F Select(F mask, F a, F b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+
+    inline I SetI(int v) { return _mm_set1_epi32(v); }
+    inline I AddI(I a, I b) { return _mm_add_epi32(a, b); }
+    inline I XorI(I a, I b) { return _mm_xor_si128(a, b); }
+    inline I AndI(I a, I b) { return _mm_and_si128(a, b); }
+    // SSE2 has no 32 bit mullo: multiply even and odd lanes to 64 bits, keep the low halves
+    inline I MulI(I a, I b)
+    {
+        I even = _mm_mul_epu32(a, b);
+        I odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+        return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+    }
+    template <int N> inline I ShiftRightI(I a) { return _mm_srai_epi32(a, N); }
+    inline I SelectI(F mask, I a, I b) { return _mm_castps_si128(Select(mask, _mm_castsi128_ps(a), _mm_castsi128_ps(b))); }
+    inline F ToFloat(I a) { return _mm_cvtepi32_ps(a); }
+    // FastFloor: truncate, minus one below zero
+    inline I Floor(F a) { return _mm_add_epi32(_mm_cvttps_epi32(a), _mm_castps_si128(_mm_cmplt_ps(a, _mm_setzero_ps()))); }
+    // No gather before AVX2
+    inline F Gather(const float* table, I index)
+    {
+        alignas(16) int i[4];
+        _mm_store_si128(reinterpret_cast<I*>(i), index);
+        return _mm_setr_ps(table[i[0]], table[i[1]], table[i[2]], table[i[3]]);
+    }
+#endif
+}
+#endif
+
 class FastNoiseLite
 {
 public:
@@ -312,6 +396,62 @@ public:
         }
     }
 
+    /// <summary>
+    /// 2D noise at `count` positions, out[i] = GetNoise(xs[i], ys[i])
+    /// </summary>
+    /// <remarks>
+    /// MINOIDS: Perlin and OpenSimplex2, single or FBm, run in SIMD lanes. Other settings fall
+    /// back to GetNoise per position.
+    /// </remarks>
+    void GetNoiseBatch(const float* xs, const float* ys, float* out, int count) const
+    {
+        int i = 0;
+#ifdef FNL_BATCH_SIMD
+        if (CanBatch())
+        {
+            using namespace FastNoiseLiteBatch;
+            for (; i + WIDTH <= count; i += WIDTH)
+            {
+                Store(out + i, GenNoiseBatch(Load(xs + i), Load(ys + i)));
+            }
+        }
+#endif
+        for (; i < count; i++)
+        {
+            out[i] = GetNoise(xs[i], ys[i]);
+        }
+    }
+
+    /// <summary>
+    /// 2D noise on a `width` x `height` grid, row by row:
+    /// out[row * width + col] = GetNoise(x0 + col * step, y0 + row * step)
+    /// </summary>
+    void GetNoiseGrid(float x0, float y0, float step, int width, int height, float* out) const
+    {
+        for (int row = 0; row < height; row++)
+        {
+            const float y = y0 + (float)row * step;
+            float* line = out + (size_t)row * width;
+            int col = 0;
+#ifdef FNL_BATCH_SIMD
+            if (CanBatch())
+            {
+                using namespace FastNoiseLiteBatch;
+                const F lanes = Lanes();
+                for (; col + WIDTH <= width; col += WIDTH)
+                {
+                    const F x = Add(Set(x0), Mul(Add(Set((float)col), lanes), Set(step)));
+                    Store(line + col, GenNoiseBatch(x, Set(y)));
+                }
+            }
+#endif
+            for (; col < width; col++)
+            {
+                line[col] = GetNoise(x0 + (float)col * step, y);
+            }
+        }
+    }
+
     /// <summary>
     /// 3D noise at given position using current settings
     /// </summary>
@@ -611,6 +751,152 @@ private:
     }
 
 
+#ifdef FNL_BATCH_SIMD
+    // MINOIDS: batch evaluation, lane for lane the same operations as the scalar code
+
+    bool CanBatch() const
+    {
+        return (mNoiseType == NoiseType_Perlin || mNoiseType == NoiseType_OpenSimplex2) &&
+               mFractalType != FractalType_Ridged && mFractalType != FractalType_PingPong;
+    }
+
+    FastNoiseLiteBatch::F GenNoiseBatch(FastNoiseLiteBatch::F x, FastNoiseLiteBatch::F y) const
+    {
+        using namespace FastNoiseLiteBatch;
+
+        // TransformNoiseCoordinate
+        x = Mul(x, Set(mFrequency));
+        y = Mul(y, Set(mFrequency));
+        if (mNoiseType == NoiseType_OpenSimplex2)
+        {
+            const float SQRT3 = (float)1.7320508075688772935274463415059;
+            const float F2 = 0.5f * (SQRT3 - 1);
+            const F t = Mul(Add(x, y), Set(F2));
+            x = Add(x, t);
+            y = Add(y, t);
+        }
+
+        if (mFractalType != FractalType_FBm)
+        {
+            return GenNoiseSingleBatch(mSeed, x, y);
+        }
+
+        // GenFractalFBm
+        int seed = mSeed;
+        F sum = Set(0);
+        F amp = Set(mFractalBounding);
+        const F one = Set(1.0f);
+        for (int i = 0; i < mOctaves; i++)
+        {
+            const F noise = GenNoiseSingleBatch(seed++, x, y);
+            sum = Add(sum, Mul(noise, amp));
+            const F weight = Mul(Min(Add(noise, one), Set(2)), Set(0.5f));
+            amp = Mul(amp, Add(one, Mul(Set(mWeightedStrength), Sub(weight, one))));
+
+            x = Mul(x, Set(mLacunarity));
+            y = Mul(y, Set(mLacunarity));
+            amp = Mul(amp, Set(mGain));
+        }
+        return sum;
+    }
+
+    FastNoiseLiteBatch::F GenNoiseSingleBatch(int seed, FastNoiseLiteBatch::F x, FastNoiseLiteBatch::F y) const
+    {
+        return mNoiseType == NoiseType_OpenSimplex2 ? SingleSimplexBatch(seed, x, y) : SinglePerlinBatch(seed, x, y);
+    }
+
+    static FastNoiseLiteBatch::F GradCoordBatch(int seed, FastNoiseLiteBatch::I xPrimed, FastNoiseLiteBatch::I yPrimed, FastNoiseLiteBatch::F xd, FastNoiseLiteBatch::F yd)
+    {
+        using namespace FastNoiseLiteBatch;
+
+        I hash = MulI(XorI(XorI(SetI(seed), xPrimed), yPrimed), SetI(0x27d4eb2d));
+        hash = XorI(hash, ShiftRightI<15>(hash));
+        hash = AndI(hash, SetI(127 << 1));
+
+        const F xg = Gather(Lookup<float>::Gradients2D, hash);
+        const F yg = Gather(Lookup<float>::Gradients2D, AddI(hash, SetI(1))); // hash | 1, hash is even
+
+        return Add(Mul(xd, xg), Mul(yd, yg));
+    }
+
+    static FastNoiseLiteBatch::F LerpBatch(FastNoiseLiteBatch::F a, FastNoiseLiteBatch::F b, FastNoiseLiteBatch::F t)
+    {
+        using namespace FastNoiseLiteBatch;
+        return Add(a, Mul(t, Sub(b, a)));
+    }
+
+    static FastNoiseLiteBatch::F SinglePerlinBatch(int seed, FastNoiseLiteBatch::F x, FastNoiseLiteBatch::F y)
+    {
+        using namespace FastNoiseLiteBatch;
+
+        I x0 = Floor(x);
+        I y0 = Floor(y);
+
+        const F xd0 = Sub(x, ToFloat(x0));
+        const F yd0 = Sub(y, ToFloat(y0));
+        const F xd1 = Sub(xd0, Set(1));
+        const F yd1 = Sub(yd0, Set(1));
+
+        // InterpQuintic
+        const F xs = Mul(Mul(Mul(xd0, xd0), xd0), Add(Mul(xd0, Sub(Mul(xd0, Set(6)), Set(15))), Set(10)));
+        const F ys = Mul(Mul(Mul(yd0, yd0), yd0), Add(Mul(yd0, Sub(Mul(yd0, Set(6)), Set(15))), Set(10)));
+
+        x0 = MulI(x0, SetI(PrimeX));
+        y0 = MulI(y0, SetI(PrimeY));
+        const I x1 = AddI(x0, SetI(PrimeX));
+        const I y1 = AddI(y0, SetI(PrimeY));
+
+        const F xf0 = LerpBatch(GradCoordBatch(seed, x0, y0, xd0, yd0), GradCoordBatch(seed, x1, y0, xd1, yd0), xs);
+        const F xf1 = LerpBatch(GradCoordBatch(seed, x0, y1, xd0, yd1), GradCoordBatch(seed, x1, y1, xd1, yd1), xs);
+
+        return Mul(LerpBatch(xf0, xf1, ys), Set(1.4247691104677813f));
+    }
+
+    // Branch free SingleSimplex: every corner is computed, masked where it has no influence
+    static FastNoiseLiteBatch::F SingleSimplexBatch(int seed, FastNoiseLiteBatch::F x, FastNoiseLiteBatch::F y)
+    {
+        using namespace FastNoiseLiteBatch;
+
+        const float SQRT3 = 1.7320508075688772935274463415059f;
+        const float G2 = (3 - SQRT3) / 6;
+        const F zero = Set(0);
+        const F half = Set(0.5f);
+
+        I i = Floor(x);
+        I j = Floor(y);
+        const F xi = Sub(x, ToFloat(i));
+        const F yi = Sub(y, ToFloat(j));
+
+        const F t = Mul(Add(xi, yi), Set(G2));
+        const F x0 = Sub(xi, t);
+        const F y0 = Sub(yi, t);
+
+        i = MulI(i, SetI(PrimeX));
+        j = MulI(j, SetI(PrimeY));
+
+        const F a = Sub(Sub(half, Mul(x0, x0)), Mul(y0, y0));
+        const F aa = Mul(a, a);
+        const F n0 = Select(Greater(a, zero), Mul(Mul(aa, aa), GradCoordBatch(seed, i, j, x0, y0)), zero);
+
+        const F c = Add(Mul(Set((float)(2 * (1 - 2 * G2) * (1 / G2 - 2))), t), Add(Set((float)(-2 * (1 - 2 * G2) * (1 - 2 * G2))), a));
+        const F x2 = Add(x0, Set(2 * (float)G2 - 1));
+        const F y2 = Add(y0, Set(2 * (float)G2 - 1));
+        const F cc = Mul(c, c);
+        const F n2 = Select(Greater(c, zero), Mul(Mul(cc, cc), GradCoordBatch(seed, AddI(i, SetI(PrimeX)), AddI(j, SetI(PrimeY)), x2, y2)), zero);
+
+        const F upper = Greater(y0, x0);
+        const F x1 = Select(upper, Add(x0, Set((float)G2)), Add(x0, Set((float)G2 - 1)));
+        const F y1 = Select(upper, Add(y0, Set((float)G2 - 1)), Add(y0, Set((float)G2)));
+        const I i1 = SelectI(upper, i, AddI(i, SetI(PrimeX)));
+        const I j1 = SelectI(upper, AddI(j, SetI(PrimeY)), j);
+        const F b = Sub(Sub(half, Mul(x1, x1)), Mul(y1, y1));
+        const F bb = Mul(b, b);
+        const F n1 = Select(Greater(b, zero), Mul(Mul(bb, bb), GradCoordBatch(seed, i1, j1, x1, y1)), zero);
+
+        return Mul(Add(Add(n0, n1), n2), Set(99.83685446303647f));
+    }
+#endif
+
     // Generic noise gen
 
     template <typename FNfloat>
@@ -0,0 +1,121 @@
+#include "alloc-tracker.hpp"
+
+#ifdef MINOIDS_TRACK_ALLOCS
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#if defined(__GLIBC__)
+#include <execinfo.h>
+#include <unistd.h>
+#define ALLOC_TRACKER_STACKS
+#endif
+
+namespace AllocTracker {
+
+static constexpr int MAX_STACK_DEPTH = 32;
+
+// Per thread for the scopes, process-wide for the frames: workers allocate for the frame too
+static thread_local Counts t_counts{0, 0};
+static std::atomic<uint64_t> s_allocations{0};
+static std::atomic<uint64_t> s_bytes{0};
+static std::atomic<uint64_t> s_frame_start{0}; // s_allocations when the frame began
+static uint64_t s_frame_start_bytes = 0;
+static Counts s_last_frame{0, 0};
+static bool s_strict = false;
+static size_t s_violations = 0;
+static size_t s_frame = 0;
+
+#ifdef ALLOC_TRACKER_STACKS
+// Of the frame's first allocation, whichever thread made it
+static void *s_stack[MAX_STACK_DEPTH];
+static std::atomic<int> s_stack_depth{0};
+static thread_local bool t_capturing = false;
+#endif
+
+static void Record(size_t size) {
+  t_counts.allocations++;
+  t_counts.bytes += size;
+  s_bytes.fetch_add(size, std::memory_order_relaxed);
+  [[maybe_unused]] const uint64_t allocation =
+      s_allocations.fetch_add(1, std::memory_order_relaxed);
+
+#ifdef ALLOC_TRACKER_STACKS
+  // First allocation of the frame, the one strict mode reports
+  if (s_strict && !t_capturing && allocation == s_frame_start.load(std::memory_order_relaxed)) {
+    t_capturing = true;
+    const int depth = backtrace(s_stack, MAX_STACK_DEPTH);
+    s_stack_depth.store(depth, std::memory_order_release);
+    t_capturing = false;
+  }
+#endif
+}
+
+Counts ThreadCounts() { return t_counts; }
+
+Counts EndFrame(bool steady) {
+  const uint64_t allocations = s_allocations.load(std::memory_order_relaxed);
+  const uint64_t bytes = s_bytes.load(std::memory_order_relaxed);
+  s_last_frame = {allocations - s_frame_start.load(std::memory_order_relaxed),
+                  bytes - s_frame_start_bytes};
+  s_frame++;
+#ifdef ALLOC_TRACKER_STACKS
+  const int stack_depth = s_stack_depth.exchange(0, std::memory_order_acquire);
+#endif
+
+  if (s_strict && steady && s_last_frame.allocations > 0) {
+    s_violations++;
+    std::fprintf(stderr, "Frame %zu allocated %llu times (%llu bytes), first allocation:\n",
+                 s_frame, static_cast<unsigned long long>(s_last_frame.allocations),
+                 static_cast<unsigned long long>(s_last_frame.bytes));
+#ifdef ALLOC_TRACKER_STACKS
+    // Writes straight to the fd, no allocation
+    backtrace_symbols_fd(s_stack, stack_depth, STDERR_FILENO);
+#endif
+  }
+
+  s_frame_start_bytes = bytes;
+  s_frame_start.store(allocations, std::memory_order_relaxed);
+  return s_last_frame;
+}
+
+Counts LastFrame() { return s_last_frame; }
+
+void SetStrict(bool strict) {
+#ifdef ALLOC_TRACKER_STACKS
+  // glibc loads the unwinder on the first call, do it before any frame is checked
+  void *warmup[1];
+  backtrace(warmup, 1);
+#endif
+  s_strict = strict;
+}
+
+size_t Violations() { return s_violations; }
+
+} // namespace AllocTracker
+
+// REPLACEMENT
+
+void *operator new(size_t size) {
+  AllocTracker::Record(size);
+  if (void *ptr = std::malloc(size ? size : 1)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+void *operator new[](size_t size) { return operator new(size); }
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+  AllocTracker::Record(size);
+  return std::malloc(size ? size : 1);
+}
+void *operator new[](size_t size, const std::nothrow_t &tag) noexcept {
+  return operator new(size, tag);
+}
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { std::free(ptr); }
+
+#endif
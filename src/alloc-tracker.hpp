@@ -0,0 +1,46 @@
+#ifndef ALLOC_TRACKER_H
+#define ALLOC_TRACKER_H
+
+// Counts every operator new of the process, per thread and per frame.
+// Build with MINOIDS_TRACK_ALLOCS, it replaces the global operator new. Without it the functions
+// below are empty inlines.
+//
+// Strict mode reports every steady-state frame that allocates, with the stack of its first
+// allocation where glibc can provide one.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace AllocTracker {
+
+struct Counts {
+  uint64_t allocations;
+  uint64_t bytes;
+};
+
+#ifdef MINOIDS_TRACK_ALLOCS
+
+// Calling thread, since it started. Scopes subtract two of these.
+Counts ThreadCounts();
+
+// Ends the frame and returns what every thread allocated during it, call from the main thread.
+// In strict mode a `steady` frame that allocated counts as a violation and is logged.
+Counts EndFrame(bool steady);
+Counts LastFrame();
+
+void SetStrict(bool strict);
+size_t Violations();
+
+#else
+
+inline Counts ThreadCounts() { return {0, 0}; }
+inline Counts EndFrame(bool steady) { return {0, 0}; }
+inline Counts LastFrame() { return {0, 0}; }
+inline void SetStrict(bool strict) {}
+inline size_t Violations() { return 0; }
+
+#endif
+
+} // namespace AllocTracker
+
+#endif
@@ -0,0 +1,185 @@
+#include "background.hpp"
+#include "FastNoiseLite.h"
+#include "jobs.hpp"
+#include "platform.hpp"
+#include "profiler.hpp"
+#include "random.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <vector>
+
+namespace Background {
+
+static constexpr int SCALE = 2; // texture pixels are SCALE x SCALE screen pixels
+static constexpr int TILE_SIZE = 32;
+static constexpr int STARS_PER_TILE = 3;
+
+// Light enough for the black outlines of the game to stay readable
+static constexpr Color BASE = RAYWHITE;
+static constexpr Color NEBULA_COLD = {176, 198, 240, 255};
+static constexpr Color NEBULA_WARM = {220, 184, 228, 255};
+static constexpr float NEBULA_STRENGTH = .8f;
+static constexpr float NEBULA_FREQUENCY = .012f;
+static constexpr float HUE_FREQUENCY = .004f;
+
+// JOBS
+static std::atomic<bool> s_cancel{false};
+static std::vector<Color> s_pixels; // each tile job writes its own pixels
+static FastNoiseLite s_nebula;
+static FastNoiseLite s_hue;
+static uint64_t s_seed = 0;
+static int s_width = 0;
+static int s_height = 0;
+static Jobs::Counter s_tiles;
+static Jobs::Counter s_upload;
+
+// MAIN THREAD
+static Texture2D s_texture{};
+static bool s_loaded = false;
+static Vector2 s_offset{};
+
+static Color Mix(Color a, Color b, float t) {
+  return {static_cast<unsigned char>(a.r + t * (b.r - a.r)),
+          static_cast<unsigned char>(a.g + t * (b.g - a.g)),
+          static_cast<unsigned char>(a.b + t * (b.b - a.b)), 255};
+}
+
+// Noise on the torus: four copies one period apart, blended by position, so column 0 continues
+// column `width` and row 0 continues row `height`. `grids` holds 4 * w * h floats.
+static void TiledGrid(const FastNoiseLite &noise, int x0, int y0, int w, int h, float *grids,
+                      float *out) {
+  const size_t size = static_cast<size_t>(w) * h;
+  noise.GetNoiseGrid(x0, y0, 1.f, w, h, grids);
+  noise.GetNoiseGrid(x0 - s_width, y0, 1.f, w, h, grids + size);
+  noise.GetNoiseGrid(x0, y0 - s_height, 1.f, w, h, grids + 2 * size);
+  noise.GetNoiseGrid(x0 - s_width, y0 - s_height, 1.f, w, h, grids + 3 * size);
+
+  for (int row = 0; row < h; row++) {
+    const float v = static_cast<float>(y0 + row) / s_height;
+    for (int col = 0; col < w; col++) {
+      const float u = static_cast<float>(x0 + col) / s_width;
+      const size_t i = static_cast<size_t>(row) * w + col;
+      const float top = grids[i] + u * (grids[size + i] - grids[i]);
+      const float bottom = grids[2 * size + i] + u * (grids[3 * size + i] - grids[2 * size + i]);
+      out[i] = top + v * (bottom - top);
+    }
+  }
+}
+
+static void GenerateTile(int tile, int columns) {
+  if (s_cancel.load(std::memory_order_relaxed)) {
+    return;
+  }
+  PROFILE_SCOPE("Background tile");
+  const int x0 = tile % columns * TILE_SIZE;
+  const int y0 = tile / columns * TILE_SIZE;
+  const int w = std::min(TILE_SIZE, s_width - x0);
+  const int h = std::min(TILE_SIZE, s_height - y0);
+
+  float grids[4 * TILE_SIZE * TILE_SIZE];
+  float density[TILE_SIZE * TILE_SIZE];
+  float tint[TILE_SIZE * TILE_SIZE];
+  TiledGrid(s_nebula, x0, y0, w, h, grids, density);
+  TiledGrid(s_hue, x0, y0, w, h, grids, tint);
+
+  for (int row = 0; row < h; row++) {
+    for (int col = 0; col < w; col++) {
+      const size_t i = static_cast<size_t>(row) * w + col;
+      // Clouds where the fractal is positive, clear space elsewhere
+      const float cloud = std::clamp(density[i] * 2.5f + .2f, 0.f, 1.f);
+      const Color color = Mix(NEBULA_COLD, NEBULA_WARM, std::clamp(tint[i] + .5f, 0.f, 1.f));
+      s_pixels[static_cast<size_t>(y0 + row) * s_width + x0 + col] =
+          Mix(BASE, color, cloud * cloud * NEBULA_STRENGTH);
+    }
+  }
+
+  // Per tile stream, the stars do not depend on the order tiles are generated in
+  Random::Generator stars(s_seed ^ static_cast<uint64_t>(tile));
+  for (int star = 0; star < STARS_PER_TILE; star++) {
+    const int x = x0 + stars.Int(0, w - 1);
+    const int y = y0 + stars.Int(0, h - 1);
+    const auto grey = static_cast<unsigned char>(stars.Int(140, 200));
+    s_pixels[static_cast<size_t>(y) * s_width + x] = {grey, grey, grey, 255};
+  }
+}
+
+// MAIN_THREAD job, once every tile is done
+static void Upload() {
+  if (s_cancel.load(std::memory_order_relaxed)) {
+    return;
+  }
+  const Image image{s_pixels.data(), s_width, s_height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8};
+  s_texture = Platform::Get().LoadTextureFromImage(image);
+  s_loaded = true;
+}
+
+void Generate(uint64_t seed, int width, int height) {
+  Unload();
+
+  s_seed = seed;
+  s_width = std::max(1, width / SCALE);
+  s_height = std::max(1, height / SCALE);
+  s_pixels.resize(static_cast<size_t>(s_width) * s_height);
+
+  s_nebula = FastNoiseLite(static_cast<int>(seed));
+  s_nebula.SetNoiseType(FastNoiseLite::NoiseType_OpenSimplex2);
+  s_nebula.SetFractalType(FastNoiseLite::FractalType_FBm);
+  s_nebula.SetFractalOctaves(5);
+  s_nebula.SetFrequency(NEBULA_FREQUENCY);
+
+  s_hue = FastNoiseLite(static_cast<int>(seed >> 32));
+  s_hue.SetNoiseType(FastNoiseLite::NoiseType_OpenSimplex2);
+  s_hue.SetFrequency(HUE_FREQUENCY);
+
+  const int columns = (s_width + TILE_SIZE - 1) / TILE_SIZE;
+  const int rows = (s_height + TILE_SIZE - 1) / TILE_SIZE;
+  for (int tile = 0; tile < columns * rows; tile++) {
+    Jobs::Run([tile, columns] { GenerateTile(tile, columns); }, &s_tiles);
+  }
+  Jobs::Run(Upload, &s_upload, &s_tiles, Jobs::MAIN_THREAD);
+}
+
+void Scroll(Vector2 offset) {
+  const float width = static_cast<float>(s_width * SCALE);
+  const float height = static_cast<float>(s_height * SCALE);
+  if (width > 0.f && height > 0.f) {
+    s_offset.x = std::fmod(std::fmod(s_offset.x + offset.x, width) + width, width);
+    s_offset.y = std::fmod(std::fmod(s_offset.y + offset.y, height) + height, height);
+  }
+}
+
+Vector2 Offset() { return s_offset; }
+
+bool IsReady() { return s_loaded; }
+
+void Draw(Vector2 offset) {
+  PROFILE_SCOPE("Background::Draw");
+  if (!s_loaded) {
+    return;
+  }
+
+  // Four copies cover the screen wherever the offset wraps
+  auto &platform = Platform::Get();
+  const float width = static_cast<float>(s_width * SCALE);
+  const float height = static_cast<float>(s_height * SCALE);
+  for (const float x : {-offset.x, width - offset.x}) {
+    for (const float y : {-offset.y, height - offset.y}) {
+      platform.DrawTextureEx(s_texture, {x, y}, 0.f, SCALE, WHITE);
+    }
+  }
+}
+
+void Unload() {
+  // Tiles not started return at once, the upload is skipped
+  s_cancel.store(true, std::memory_order_relaxed);
+  Jobs::Wait(s_tiles);
+  Jobs::Wait(s_upload);
+  s_cancel.store(false, std::memory_order_relaxed);
+  if (s_loaded) {
+    Platform::Get().UnloadTexture(s_texture);
+    s_loaded = false;
+  }
+}
+
+} // namespace Background
@@ -0,0 +1,40 @@
+#ifndef BACKGROUND_H
+#define BACKGROUND_H
+
+// Backdrop of the game scene: a fractal noise nebula with stars, generated by one job per tile
+// and uploaded as one texture by a main thread job once all are done. Until then the frame keeps
+// its clear color, so generation never holds up the main loop.
+//
+//   Background::Generate(seed, width, height); // scene load
+//   Background::Scroll(offset);                // per step, parallax
+//   Background::Draw(Background::Offset());    // first thing drawn
+//
+// The image tiles with a period of one screen, so it scrolls forever without a seam. Scroll
+// and Offset belong to the simulation, Draw to the main thread: a frame drawn while the next
+// step runs passes the offset it was built with.
+
+#include "raylib.h"
+#include <cstdint>
+
+namespace Background {
+
+// Restarts generation for a `width` x `height` screen, cancelling one in progress
+void Generate(uint64_t seed, int width, int height);
+
+// Moves the backdrop by `offset` screen pixels
+void Scroll(Vector2 offset);
+
+// Scrolled so far, in [0, size) screen pixels
+Vector2 Offset();
+
+// Draws nothing until the texture is uploaded
+void Draw(Vector2 offset);
+
+bool IsReady();
+
+// Cancels generation and frees the texture
+void Unload();
+
+} // namespace Background
+
+#endif
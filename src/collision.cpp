@@ -0,0 +1,341 @@
+#include "collision.hpp"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define COLLISION_SIMD_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define COLLISION_SIMD_SSE2
+#endif
+
+namespace ECS {
+
+static int32_t CellCoord(float value, float cell_size) {
+  return static_cast<int32_t>(std::floor(value / cell_size));
+}
+
+static uint64_t PackCell(int32_t cx, int32_t cy) {
+  return (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) | static_cast<uint32_t>(cy);
+}
+
+static bool Overlaps(const Rectangle &a, const Rectangle &b) {
+  return a.x <= b.x + b.width && b.x <= a.x + a.width && a.y <= b.y + b.height &&
+         b.y <= a.y + a.height;
+}
+
+float ProfileRadius(const float *offsets, size_t count, float base_radius, float angle) {
+  constexpr float TWO_PI = 2.f * PI;
+  float turns = angle / TWO_PI;
+  turns -= std::floor(turns); // [0, 1)
+
+  const float index = turns * count;
+  const size_t i = static_cast<size_t>(index) % count;
+  const size_t next = (i + 1) % count;
+  const float t = index - std::floor(index);
+  return base_radius + offsets[i] + (offsets[next] - offsets[i]) * t;
+}
+
+uint64_t Broadphase::CellKey(float x, float y) const {
+  return PackCell(CellCoord(x, m_cell_size), CellCoord(y, m_cell_size));
+}
+
+void Broadphase::Update(const std::vector<CollisionProxy> &proxies) {
+  m_entries.clear();
+  m_pairs.clear();
+
+  // Bin proxies
+  for (uint32_t i = 0; i < proxies.size(); i++) {
+    const auto &proxy = proxies[i];
+    if (CollisionLayer::NONE == proxy.category || CollisionLayer::NONE == proxy.mask) {
+      continue;
+    }
+
+    const int32_t x0 = CellCoord(proxy.bounds.x, m_cell_size);
+    const int32_t x1 = CellCoord(proxy.bounds.x + proxy.bounds.width, m_cell_size);
+    const int32_t y0 = CellCoord(proxy.bounds.y, m_cell_size);
+    const int32_t y1 = CellCoord(proxy.bounds.y + proxy.bounds.height, m_cell_size);
+
+    for (int32_t cx = x0; cx <= x1; cx++) {
+      for (int32_t cy = y0; cy <= y1; cy++) {
+        m_entries.push_back({PackCell(cx, cy), i});
+      }
+    }
+  }
+
+  std::sort(m_entries.begin(), m_entries.end(), [](const CellEntry &lhs, const CellEntry &rhs) {
+    return lhs.cell < rhs.cell || (lhs.cell == rhs.cell && lhs.proxy < rhs.proxy);
+  });
+
+  // Visit cells
+  for (size_t begin = 0; begin < m_entries.size();) {
+    const uint64_t cell = m_entries[begin].cell;
+    size_t end = begin;
+    CollisionMask categories = CollisionLayer::NONE;
+    CollisionMask masks = CollisionLayer::NONE;
+    while (end < m_entries.size() && m_entries[end].cell == cell) {
+      categories |= proxies[m_entries[end].proxy].category;
+      masks |= proxies[m_entries[end].proxy].mask;
+      ++end;
+    }
+
+    // Nobody in here reacts to anybody in here
+    if (end - begin < 2 || (categories & masks) == 0) {
+      begin = end;
+      continue;
+    }
+
+    for (size_t i = begin; i < end - 1; i++) {
+      const auto &proxyA = proxies[m_entries[i].proxy];
+      for (size_t j = i + 1; j < end; j++) {
+        const auto &proxyB = proxies[m_entries[j].proxy];
+        if (!CanCollide(proxyA.category, proxyA.mask, proxyB.category, proxyB.mask) ||
+            !Overlaps(proxyA.bounds, proxyB.bounds)) {
+          continue;
+        }
+
+        // Pairs spanning several cells are reported by the cell holding their overlap's corner
+        if (CellKey(std::max(proxyA.bounds.x, proxyB.bounds.x),
+                    std::max(proxyA.bounds.y, proxyB.bounds.y)) != cell) {
+          continue;
+        }
+
+        m_pairs.push_back({m_entries[i].proxy, m_entries[j].proxy});
+      }
+    }
+
+    begin = end;
+  }
+}
+
+// NARROWPHASE
+
+void CircleRectBatch::Reserve(size_t count) {
+  cx.reserve(count);
+  cy.reserve(count);
+  radius.reserve(count);
+  rx.reserve(count);
+  ry.reserve(count);
+  half_w.reserve(count);
+  half_h.reserve(count);
+  pair.reserve(count);
+}
+
+void CircleRectBatch::Clear() {
+  cx.clear();
+  cy.clear();
+  radius.clear();
+  rx.clear();
+  ry.clear();
+  half_w.clear();
+  half_h.clear();
+  pair.clear();
+}
+
+void CircleRectBatch::Add(uint32_t pair_index, const Vector2 &center, float circle_radius,
+                          const Rectangle &rec) {
+  cx.push_back(center.x);
+  cy.push_back(center.y);
+  radius.push_back(circle_radius);
+  half_w.push_back(rec.width / 2.f);
+  half_h.push_back(rec.height / 2.f);
+  rx.push_back(rec.x + rec.width / 2.f);
+  ry.push_back(rec.y + rec.height / 2.f);
+  pair.push_back(pair_index);
+}
+
+void CircleCircleBatch::Reserve(size_t count) {
+  ax.reserve(count);
+  ay.reserve(count);
+  bx.reserve(count);
+  by.reserve(count);
+  radius_sum.reserve(count);
+  pair.reserve(count);
+}
+
+void CircleCircleBatch::Clear() {
+  ax.clear();
+  ay.clear();
+  bx.clear();
+  by.clear();
+  radius_sum.clear();
+  pair.clear();
+}
+
+void CircleCircleBatch::Add(uint32_t pair_index, const Vector2 &centerA, float radiusA,
+                            const Vector2 &centerB, float radiusB) {
+  ax.push_back(centerA.x);
+  ay.push_back(centerA.y);
+  bx.push_back(centerB.x);
+  by.push_back(centerB.y);
+  radius_sum.push_back(radiusA + radiusB);
+  pair.push_back(pair_index);
+}
+
+static void ResetMask(std::vector<uint32_t> &hit_mask, size_t count) {
+  hit_mask.assign((count + 31) / 32, 0u);
+}
+
+static void SetMaskBit(std::vector<uint32_t> &hit_mask, size_t index) {
+  hit_mask[index / 32] |= 1u << (index % 32);
+}
+
+// Distance from the circle center to the closest point of the rectangle vs the radius
+static bool CircleRectScalar(const CircleRectBatch &b, size_t i) {
+  const float dx = std::max(std::fabs(b.cx[i] - b.rx[i]) - b.half_w[i], 0.f);
+  const float dy = std::max(std::fabs(b.cy[i] - b.ry[i]) - b.half_h[i], 0.f);
+  return dx * dx + dy * dy <= b.radius[i] * b.radius[i];
+}
+
+static bool CircleCircleScalar(const CircleCircleBatch &b, size_t i) {
+  const float dx = b.ax[i] - b.bx[i];
+  const float dy = b.ay[i] - b.by[i];
+  return dx * dx + dy * dy <= b.radius_sum[i] * b.radius_sum[i];
+}
+
+void TestCircleRects(const CircleRectBatch &b, std::vector<uint32_t> &hit_mask) {
+  const size_t count = b.Size();
+  ResetMask(hit_mask, count);
+  size_t i = 0;
+
+#if defined(COLLISION_SIMD_AVX)
+  const __m256 sign = _mm256_set1_ps(-0.f);
+  const __m256 zero = _mm256_setzero_ps();
+  for (; i + 8 <= count; i += 8) {
+    __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(&b.cx[i]), _mm256_loadu_ps(&b.rx[i]));
+    __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(&b.cy[i]), _mm256_loadu_ps(&b.ry[i]));
+    dx = _mm256_max_ps(_mm256_sub_ps(_mm256_andnot_ps(sign, dx), _mm256_loadu_ps(&b.half_w[i])),
+                       zero);
+    dy = _mm256_max_ps(_mm256_sub_ps(_mm256_andnot_ps(sign, dy), _mm256_loadu_ps(&b.half_h[i])),
+                       zero);
+    const __m256 dist = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+    const __m256 r = _mm256_loadu_ps(&b.radius[i]);
+    const uint32_t lanes =
+        _mm256_movemask_ps(_mm256_cmp_ps(dist, _mm256_mul_ps(r, r), _CMP_LE_OQ));
+    hit_mask[i / 32] |= lanes << (i % 32);
+  }
+#elif defined(COLLISION_SIMD_SSE2)
+  const __m128 sign = _mm_set1_ps(-0.f);
+  const __m128 zero = _mm_setzero_ps();
+  for (; i + 4 <= count; i += 4) {
+    __m128 dx = _mm_sub_ps(_mm_loadu_ps(&b.cx[i]), _mm_loadu_ps(&b.rx[i]));
+    __m128 dy = _mm_sub_ps(_mm_loadu_ps(&b.cy[i]), _mm_loadu_ps(&b.ry[i]));
+    dx = _mm_max_ps(_mm_sub_ps(_mm_andnot_ps(sign, dx), _mm_loadu_ps(&b.half_w[i])), zero);
+    dy = _mm_max_ps(_mm_sub_ps(_mm_andnot_ps(sign, dy), _mm_loadu_ps(&b.half_h[i])), zero);
+    const __m128 dist = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+    const __m128 r = _mm_loadu_ps(&b.radius[i]);
+    const uint32_t lanes = _mm_movemask_ps(_mm_cmple_ps(dist, _mm_mul_ps(r, r)));
+    hit_mask[i / 32] |= lanes << (i % 32);
+  }
+#endif
+
+  for (; i < count; i++) {
+    if (CircleRectScalar(b, i)) {
+      SetMaskBit(hit_mask, i);
+    }
+  }
+}
+
+void TestCircleCircles(const CircleCircleBatch &b, std::vector<uint32_t> &hit_mask) {
+  const size_t count = b.Size();
+  ResetMask(hit_mask, count);
+  size_t i = 0;
+
+#if defined(COLLISION_SIMD_AVX)
+  for (; i + 8 <= count; i += 8) {
+    const __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(&b.ax[i]), _mm256_loadu_ps(&b.bx[i]));
+    const __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(&b.ay[i]), _mm256_loadu_ps(&b.by[i]));
+    const __m256 dist = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+    const __m256 r = _mm256_loadu_ps(&b.radius_sum[i]);
+    const uint32_t lanes =
+        _mm256_movemask_ps(_mm256_cmp_ps(dist, _mm256_mul_ps(r, r), _CMP_LE_OQ));
+    hit_mask[i / 32] |= lanes << (i % 32);
+  }
+#elif defined(COLLISION_SIMD_SSE2)
+  for (; i + 4 <= count; i += 4) {
+    const __m128 dx = _mm_sub_ps(_mm_loadu_ps(&b.ax[i]), _mm_loadu_ps(&b.bx[i]));
+    const __m128 dy = _mm_sub_ps(_mm_loadu_ps(&b.ay[i]), _mm_loadu_ps(&b.by[i]));
+    const __m128 dist = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+    const __m128 r = _mm_loadu_ps(&b.radius_sum[i]);
+    const uint32_t lanes = _mm_movemask_ps(_mm_cmple_ps(dist, _mm_mul_ps(r, r)));
+    hit_mask[i / 32] |= lanes << (i % 32);
+  }
+#endif
+
+  for (; i < count; i++) {
+    if (CircleCircleScalar(b, i)) {
+      SetMaskBit(hit_mask, i);
+    }
+  }
+}
+
+Narrowphase::Narrowphase() {
+  m_circle_rects.Reserve(INITIAL_PAIRS);
+  m_circle_circles.Reserve(INITIAL_PAIRS);
+  m_hit_mask.reserve((INITIAL_PAIRS + 31) / 32);
+  m_pair_hits.reserve(INITIAL_PAIRS);
+}
+
+void Narrowphase::Reset(size_t pair_count) {
+  m_circle_rects.Clear();
+  m_circle_circles.Clear();
+  m_circle_rects.Reserve(pair_count);
+  m_circle_circles.Reserve(pair_count);
+  m_hit_mask.reserve((pair_count + 31) / 32);
+  m_pair_hits.assign(pair_count, 0);
+}
+
+void Narrowphase::Run() {
+  TestCircleRects(m_circle_rects, m_hit_mask);
+  for (size_t i = 0; i < m_circle_rects.Size(); i++) {
+    if (IsHit(m_hit_mask, i)) {
+      m_pair_hits[m_circle_rects.pair[i]] = 1;
+    }
+  }
+
+  TestCircleCircles(m_circle_circles, m_hit_mask);
+  for (size_t i = 0; i < m_circle_circles.Size(); i++) {
+    if (IsHit(m_hit_mask, i)) {
+      m_pair_hits[m_circle_circles.pair[i]] = 1;
+    }
+  }
+}
+
+// PAIR CACHE
+
+static bool SameVector(const Vector2 &lhs, const Vector2 &rhs) {
+  return lhs.x == rhs.x && lhs.y == rhs.y;
+}
+
+bool PairCache::Lookup(size_t a, size_t b, const Vector2 &offset, const Vector2 &dims_a,
+                       const Vector2 &dims_b, bool &touching) const {
+  const uint64_t key = Key(a, b);
+  const auto it = std::lower_bound(m_previous.begin(), m_previous.end(), key,
+                                   [](const Entry &entry, uint64_t k) { return entry.key < k; });
+  if (it == m_previous.end() || it->key != key) {
+    return false;
+  }
+
+  // Nothing moved relative to each other, the result still holds
+  if (SameVector(it->offset, offset) && SameVector(it->dims_a, dims_a) &&
+      SameVector(it->dims_b, dims_b)) {
+    touching = it->touching;
+    return true;
+  }
+  return false;
+}
+
+void PairCache::Store(size_t a, size_t b, const Vector2 &offset, const Vector2 &dims_a,
+                      const Vector2 &dims_b, bool touching) {
+  m_current.push_back({Key(a, b), a, b, offset, dims_a, dims_b, touching});
+}
+
+void PairCache::EndFrame() {
+  std::sort(m_current.begin(), m_current.end(),
+            [](const Entry &lhs, const Entry &rhs) { return lhs.key < rhs.key; });
+  std::swap(m_previous, m_current);
+  m_current.clear();
+}
+
+} // namespace ECS
@@ -0,0 +1,184 @@
+#ifndef COLLISION_H
+#define COLLISION_H
+
+#include "raylib.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ECS {
+
+// Collision categories. A collider has one category and a mask of the categories it reacts to,
+// a pair is only tested when each side's category is in the other side's mask.
+using CollisionMask = uint8_t;
+
+namespace CollisionLayer {
+constexpr CollisionMask NONE = 0;
+constexpr CollisionMask SHIP = 1 << 0;
+constexpr CollisionMask BEAM = 1 << 1;
+constexpr CollisionMask METEOR = 1 << 2;
+constexpr CollisionMask CORE = 1 << 3;
+constexpr CollisionMask PARTICLE = 1 << 4;
+
+// What each kind of collider reacts to
+constexpr CollisionMask SHIP_MASK = METEOR | CORE;
+constexpr CollisionMask BEAM_MASK = METEOR | CORE;
+constexpr CollisionMask METEOR_MASK = SHIP | BEAM | METEOR;
+constexpr CollisionMask CORE_MASK = SHIP | BEAM;
+} // namespace CollisionLayer
+
+inline bool CanCollide(CollisionMask categoryA, CollisionMask maskA, CollisionMask categoryB,
+                       CollisionMask maskB) {
+  return (categoryA & maskB) && (categoryB & maskA);
+}
+
+// Radius of a closed outline at `angle` (radians). `offsets` are added to base_radius at `count`
+// evenly spaced angles starting at 0, values in between are interpolated.
+float ProfileRadius(const float *offsets, size_t count, float base_radius, float angle);
+
+// What the broadphase knows about a collider: its world bounds and layers
+struct CollisionProxy {
+  Rectangle bounds;
+  CollisionMask category;
+  CollisionMask mask;
+};
+
+// Indices into the proxies passed to Broadphase::Update, a < b
+struct CollisionPair {
+  uint32_t a;
+  uint32_t b;
+};
+
+// Broadphase cell entries and pairs, narrowphase tests per batch: reserved up front, steady
+// frames stay below it
+constexpr size_t INITIAL_PAIRS = 4096;
+
+// Uniform grid broadphase.
+// Proxies are binned into square cells and only pairs sharing a cell are reported. Cells whose
+// population can't interact at all (i.e only meteors) are skipped without visiting their pairs.
+class Broadphase {
+public:
+  explicit Broadphase(float cell_size = 64.f) : m_cell_size(cell_size) {
+    m_entries.reserve(INITIAL_PAIRS);
+    m_pairs.reserve(INITIAL_PAIRS);
+  }
+
+  void Update(const std::vector<CollisionProxy> &proxies);
+
+  // Candidate pairs that pass the layer test and whose bounds overlap, each reported once
+  const std::vector<CollisionPair> &Pairs() const { return m_pairs; }
+
+private:
+  struct CellEntry {
+    uint64_t cell;
+    uint32_t proxy;
+  };
+
+  uint64_t CellKey(float x, float y) const;
+
+  float m_cell_size;
+  std::vector<CellEntry> m_entries; // reused across frames
+  std::vector<CollisionPair> m_pairs;
+};
+
+// Circle vs rectangle tests in SoA layout, rectangles kept as center + half extents
+struct CircleRectBatch {
+  std::vector<float> cx, cy, radius;
+  std::vector<float> rx, ry, half_w, half_h;
+  std::vector<uint32_t> pair;
+
+  void Reserve(size_t count);
+  void Clear();
+  void Add(uint32_t pair_index, const Vector2 &center, float circle_radius, const Rectangle &rec);
+  size_t Size() const { return pair.size(); }
+};
+
+// Circle vs circle tests in SoA layout
+struct CircleCircleBatch {
+  std::vector<float> ax, ay, bx, by, radius_sum;
+  std::vector<uint32_t> pair;
+
+  void Reserve(size_t count);
+  void Clear();
+  void Add(uint32_t pair_index, const Vector2 &centerA, float radiusA, const Vector2 &centerB,
+           float radiusB);
+  size_t Size() const { return pair.size(); }
+};
+
+// Evaluate a whole batch, bit i of the mask is set when test i overlaps.
+// Uses AVX (8 lanes) or SSE2 (4 lanes) when available, scalar otherwise.
+void TestCircleRects(const CircleRectBatch &batch, std::vector<uint32_t> &hit_mask);
+void TestCircleCircles(const CircleCircleBatch &batch, std::vector<uint32_t> &hit_mask);
+
+inline bool IsHit(const std::vector<uint32_t> &hit_mask, size_t index) {
+  return (hit_mask[index / 32] >> (index % 32)) & 1u;
+}
+
+// Gathers the broadphase candidates by shape combination and runs them in batches
+class Narrowphase {
+public:
+  Narrowphase();
+
+  // Reserves for `pair_count` tests before they are added, a frame with more pairs than any
+  // before grows the batches once
+  void Reset(size_t pair_count);
+
+  void AddCircleRect(uint32_t pair, const Vector2 &center, float radius, const Rectangle &rec) {
+    m_circle_rects.Add(pair, center, radius, rec);
+  }
+  void AddCircleCircle(uint32_t pair, const Vector2 &centerA, float radiusA,
+                       const Vector2 &centerB, float radiusB) {
+    m_circle_circles.Add(pair, centerA, radiusA, centerB, radiusB);
+  }
+  // For pairs resolved outside the batches
+  void SetHit(uint32_t pair) { m_pair_hits[pair] = 1; }
+
+  void Run();
+
+  bool Hit(uint32_t pair) const { return m_pair_hits[pair] != 0; }
+
+private:
+  CircleRectBatch m_circle_rects;
+  CircleCircleBatch m_circle_circles;
+  std::vector<uint32_t> m_hit_mask;
+  std::vector<uint8_t> m_pair_hits; // indexed by broadphase pair
+};
+
+// Remembers narrowphase results per entity pair across frames.
+// A pair whose relative offset and sizes are unchanged since last frame reuses its result.
+class PairCache {
+public:
+  PairCache() {
+    m_previous.reserve(INITIAL_PAIRS);
+    m_current.reserve(INITIAL_PAIRS);
+  }
+
+  // Sets `touching` and returns true when the pair can skip the narrowphase
+  bool Lookup(size_t a, size_t b, const Vector2 &offset, const Vector2 &dims_a,
+              const Vector2 &dims_b, bool &touching) const;
+  void Store(size_t a, size_t b, const Vector2 &offset, const Vector2 &dims_a,
+             const Vector2 &dims_b, bool touching);
+
+  // This frame's pairs become the ones Lookup finds
+  void EndFrame();
+
+private:
+  struct Entry {
+    uint64_t key;
+    size_t a, b;
+    Vector2 offset; // b - a
+    Vector2 dims_a, dims_b;
+    bool touching;
+  };
+
+  static uint64_t Key(size_t a, size_t b) {
+    return (static_cast<uint64_t>(a) << 32) | static_cast<uint32_t>(b);
+  }
+
+  std::vector<Entry> m_previous; // sorted by key
+  std::vector<Entry> m_current;
+};
+
+} // namespace ECS
+
+#endif
@@ -1,6 +1,7 @@
 #include "ecs.hpp"
 #include "fmt/core.h"
 #include "game.hpp"
+#include "profiler.hpp"
 #include "raylib.h"
 #include "raymath.h"
 #include "reasings.h"
@@ -8,7 +9,6 @@
 #include <cmath>
 #include <functional>
 #include <optional>
-#include <random>
 #include <string>
 #include <variant>
 
@@ -19,18 +19,17 @@ std::atomic<size_t> ThreadSafeIdGenerator::counter(0);
 // std::unordered_map<std::type_index, std::bitset<MAX_COMPONENTS>> s_typeToBitSetMap;
 
 Entity Registry::CreateEntity() {
+  CheckAccess(Resource::ENTITIES, true);
   size_t index = ThreadSafeIdGenerator::getNextId();
   m_entities.push_back(index);
   return index;
 }
 
 Registry::~Registry() {
-  if (m_entities.size() > 0) {
-    for (auto it = m_entities.begin(); it != m_entities.end();) {
-      CleanupEntity(*it);
-      it = m_entities.erase(it);
-    }
+  for (const Entity entity : m_entities) {
+    CleanupEntity(entity);
   }
+  m_entities.clear();
 }
 
 void Registry::CleanupEntity(Entity entity) {
@@ -50,29 +49,61 @@ void Registry::CleanupEntity(Entity entity) {
   Remove<InputComponent>(entity);
   Remove<EmitterComponent>(entity);
   Remove<ParticleComponent>(entity);
+  Remove<BodyComponent>(entity);
 }
 
 void Registry::DeleteEntity(Entity entity) {
+  CheckAccess(Resource::ENTITIES, true);
   CleanupEntity(entity);
   m_entities.erase(std::remove(m_entities.begin(), m_entities.end(), entity), m_entities.end());
 }
 
 void Registry::Init() {
+  m_collision_proxies.reserve(INITIAL_ELEMENTS); // as many as the collider pool holds
+  m_pair_touching.reserve(INITIAL_PAIRS);
+  m_pair_cached.reserve(INITIAL_PAIRS);
+  m_body_contacts.reserve(INITIAL_PAIRS);
+  m_solver.Reserve(INITIAL_ELEMENTS, INITIAL_PAIRS);
+  m_solver_bodies.reserve(INITIAL_ELEMENTS);
+  m_solver_index.reserve(INITIAL_ELEMENTS);
   // TODO: Experimentation - remove
   // s_typeToBitSetMap[std::type_index(typeid(TransformComponent))] = 1 << 0;
   // s_typeToBitSetMap[std::type_index(typeid(RenderComponent))] = 1 << 1;
   // s_typeToBitSetMap[std::type_index(typeid(CollisionComponent))] = 1 << 2;
-  gen = std::mt19937(rd());
 }
 
 void Registry::PositionSystem() {
-  float screen_width = GetScreenWidth();
-  float screen_height = GetScreenHeight();
+  PROFILE_SCOPE("PositionSystem");
+  const float screen_width =
+      m_world_size ? m_world_size->x : static_cast<float>(Platform::Get().GetScreenWidth());
+  const float screen_height =
+      m_world_size ? m_world_size->y : static_cast<float>(Platform::Get().GetScreenHeight());
+
+  // ideally, size should be included
+  auto wrap = [screen_width, screen_height](PositionComponent &pos) {
+    if (pos.value.x < -30.f) {
+      pos.value.x = screen_width;
+      pos.previous = pos.value; // teleport, do not interpolate
+    } else if (pos.value.x > screen_width + 30.f) {
+      pos.value.x = 0;
+      pos.previous = pos.value;
+    }
+
+    if (pos.value.y < -30.f) {
+      pos.value.y = screen_height;
+      pos.previous = pos.value;
+    } else if (pos.value.y > screen_height + 30.f) {
+      pos.value.y = 0;
+      pos.previous = pos.value;
+    }
+  };
+
+  // Every position only changes its own entity, weapons follow their shooter below
+  ParallelEach<PositionComponent>([this, &wrap](PositionComponent &pos) {
+    pos.previous = pos.value;
 
-  for (auto &pos : m_positions.dense) {
     const auto force = m_forces.Get(pos.entity);
     auto velocity = m_velocities.Get(pos.entity);
-    auto weapon = m_weapons.Get(pos.entity);
 
     if (force) {
       // A = F / M, M == 1
@@ -86,80 +117,262 @@ void Registry::PositionSystem() {
     } else if (velocity) {
       pos.value.x += velocity->value.x;
       pos.value.y += velocity->value.y;
-    } else if (weapon) {
-      const auto shooterPos = m_positions.Get(weapon->shooter);
-      const auto shooterSprite = m_sprites.Get(weapon->shooter);
-      // offsets are due to weapon size - TODO: address this
-      pos.value.x = shooterPos->value.x + shooterSprite->texture.width / 2.f - 5.f;
-      pos.value.y = shooterPos->value.y + shooterSprite->texture.height / 2.f - 8.f;
+    } else if (m_weapons.Get(pos.entity)) {
+      return;
     }
+    wrap(pos);
+  });
 
-    // ideally, size should be included
-    if (pos.value.x < -30.f) {
-      pos.value.x = screen_width;
-    } else if (pos.value.x > screen_width + 30.f) {
-      pos.value.x = 0;
-    }
-
-    if (pos.value.y < -30.f) {
-      pos.value.y = screen_height;
-    } else if (pos.value.y > screen_height + 30.f) {
-      pos.value.y = 0;
+  for (const auto &weapon : m_weapons.dense) {
+    auto pos = m_positions.Get(weapon.entity);
+    if (!pos || m_forces.Get(weapon.entity) || m_velocities.Get(weapon.entity)) {
+      continue;
     }
+    const auto shooterPos = m_positions.Get(weapon.shooter);
+    const auto shooterSprite = m_sprites.Get(weapon.shooter);
+    // offsets are due to weapon size - TODO: address this
+    pos->value.x = shooterPos->value.x + shooterSprite->texture.width / 2.f - 5.f;
+    pos->value.y = shooterPos->value.y + shooterSprite->texture.height / 2.f - 8.f;
+    wrap(*pos);
   }
 }
 
-bool HandleCollision(ColliderComponent &colA, ColliderComponent &colB,
-                     const PositionComponent *posA, const PositionComponent *posB) {
-  const auto &dimA = colA.dimensions;
+static Rectangle ColliderBounds(const ColliderComponent &collider, const Vector2 &pos) {
+  if (collider.IsRound()) {
+    const float radius = collider.BoundingRadius();
+    return {pos.x - radius, pos.y - radius, 2.f * radius, 2.f * radius};
+  }
+  // RECTANGLE anchor is top-left
+  return {pos.x, pos.y, collider.dimensions.x, collider.dimensions.y};
+}
 
-  bool collides = CheckCollisionCircleRec(posB->value, colB.dimensions.x,
-                                          {posA->value.x, posA->value.y, dimA.x, dimA.y});
+// Outline radius of a round collider towards `target`, METEORS follow their rendered noise
+// profile, anything else is a plain circle
+static float OutlineRadius(const ColliderComponent &collider, const RenderComponent *render,
+                           const Vector2 &center, const Vector2 &target) {
+  if (Shape::METEOR != collider.shape || !render || Shape::METEOR != render->shape) {
+    return collider.dimensions.x;
+  }
+  const float angle = atan2f(target.y - center.y, target.x - center.x);
+  return MeteorShapes::Radius(render->profile, collider.dimensions.x, render->dimensions.y,
+                              angle);
+}
 
-  if (collides) {
-    colA.collided_with = colB.entity;
-    colB.collided_with = colA.entity;
-    return true;
+// Exact test for pairs whose bounding circles overlap and where one side is a METEOR
+bool Registry::MeteorCollision(const ColliderComponent &colA, const ColliderComponent &colB,
+                               const Vector2 &posA, const Vector2 &posB) {
+  const auto renderA = m_renders.Get(colA.entity);
+  const auto renderB = m_renders.Get(colB.entity);
+
+  if (!colA.IsRound()) {
+    // Closest point of the rectangle to the meteor center
+    const Rectangle rec{posA.x, posA.y, colA.dimensions.x, colA.dimensions.y};
+    const Vector2 closest{Clamp(posB.x, rec.x, rec.x + rec.width),
+                          Clamp(posB.y, rec.y, rec.y + rec.height)};
+    return Vector2Distance(closest, posB) <= OutlineRadius(colB, renderB, posB, closest);
+  } else if (!colB.IsRound()) {
+    return MeteorCollision(colB, colA, posB, posA);
   }
 
-  return false;
+  return Vector2Distance(posA, posB) <=
+         OutlineRadius(colA, renderA, posA, posB) + OutlineRadius(colB, renderB, posB, posA);
 }
 
 void Registry::CollisionDetectionSystem() {
-  const auto &positionComponents = m_positions.dense;
+  PROFILE_SCOPE("CollisionDetectionSystem");
   auto &colliderComps = m_colliders.dense;
 
-  for (size_t indexA = 0; indexA < colliderComps.size() - 1; indexA++) {
-    for (size_t indexB = indexA + 1; indexB < m_colliders.dense.size(); indexB++) {
-      auto posA = m_positions.Get(colliderComps[indexA].entity);
-      auto posB = m_positions.Get(colliderComps[indexB].entity);
+  // Proxies for the broadphase, colliders without a position never collide
+  m_collision_proxies.resize(colliderComps.size());
+  for (size_t i = 0; i < colliderComps.size(); i++) {
+    const auto &collider = colliderComps[i];
+    const auto pos = m_positions.Get(collider.entity);
+    auto &proxy = m_collision_proxies[i];
+    if (pos) {
+      proxy.bounds = ColliderBounds(collider, pos->value);
+      proxy.category = collider.category;
+      proxy.mask = collider.mask;
+    } else {
+      proxy.category = CollisionLayer::NONE;
+      proxy.mask = CollisionLayer::NONE;
+    }
+  }
 
-      // TODO: (Edge Case) Need to address this later
-      if (!posB || !posA) {
-        continue;
+  m_broadphase.Update(m_collision_proxies);
+  const auto &pairs = m_broadphase.Pairs();
+
+  // Narrowphase: gather candidates per shape combination and test them in batches,
+  // pairs that didn't move relative to each other since last frame reuse their cached result
+  m_narrowphase.Reset(pairs.size());
+  m_body_contacts.clear();
+  m_pair_touching.assign(pairs.size(), 0);
+  m_pair_cached.assign(pairs.size(), 0);
+  for (uint32_t i = 0; i < pairs.size(); i++) {
+    const auto &colA = colliderComps[pairs[i].a];
+    const auto &colB = colliderComps[pairs[i].b];
+    const auto &posA = m_positions.Get(colA.entity)->value;
+    const auto &posB = m_positions.Get(colB.entity)->value;
+
+    bool touching = false;
+    const bool ordered = colA.entity < colB.entity;
+    if (ordered ? m_pair_cache.Lookup(colA.entity, colB.entity, Vector2Subtract(posB, posA),
+                                      colA.dimensions, colB.dimensions, touching)
+                : m_pair_cache.Lookup(colB.entity, colA.entity, Vector2Subtract(posA, posB),
+                                      colB.dimensions, colA.dimensions, touching)) {
+      m_pair_cached[i] = 1;
+      m_pair_touching[i] = touching;
+      continue;
+    }
+
+    const bool roundA = colA.IsRound();
+    const bool roundB = colB.IsRound();
+
+    // METEORS are tested by their bounding circle here and refined below
+    if (roundA && roundB) {
+      m_narrowphase.AddCircleCircle(i, posA, colA.BoundingRadius(), posB, colB.BoundingRadius());
+    } else if (roundA) {
+      m_narrowphase.AddCircleRect(i, posA, colA.BoundingRadius(),
+                                  m_collision_proxies[pairs[i].b].bounds);
+    } else if (roundB) {
+      m_narrowphase.AddCircleRect(i, posB, colB.BoundingRadius(),
+                                  m_collision_proxies[pairs[i].a].bounds);
+    } else {
+      // RECTANGLES: the broadphase bounds test was exact
+      m_narrowphase.SetHit(i);
+    }
+  }
+  m_narrowphase.Run();
+
+  for (uint32_t i = 0; i < pairs.size(); i++) {
+    auto &colA = colliderComps[pairs[i].a];
+    auto &colB = colliderComps[pairs[i].b];
+    const auto &posA = m_positions.Get(colA.entity)->value;
+    const auto &posB = m_positions.Get(colB.entity)->value;
+
+    if (!m_pair_cached[i]) {
+      bool touching = m_narrowphase.Hit(i);
+      if (touching && (Shape::METEOR == colA.shape || Shape::METEOR == colB.shape)) {
+        touching = MeteorCollision(colA, colB, posA, posB);
       }
+      m_pair_touching[i] = touching;
+    }
 
-      // Optimizations:
-      // RECTANGLE expected to be our Spaceship or its MiningBeam (weapon),
-      // Circles are expected to be our Meteors
-      // Circles do not expect to collide each other so,
-      // Rectangle is expected to collide with only 1 Circle
-      if (Shape::RECTANGLE == colliderComps[indexA].shape &&
-          Shape::CIRCLE == colliderComps[indexB].shape) {
-        if (HandleCollision(colliderComps[indexA], colliderComps[indexB], posA, posB)) {
-          break;
-        }
-      } else if (Shape::RECTANGLE == colliderComps[indexB].shape &&
-                 Shape::CIRCLE == colliderComps[indexA].shape) {
-        if (HandleCollision(colliderComps[indexB], colliderComps[indexA], posB, posA)) {
-          break;
+    if (colA.entity < colB.entity) {
+      m_pair_cache.Store(colA.entity, colB.entity, Vector2Subtract(posB, posA), colA.dimensions,
+                         colB.dimensions, m_pair_touching[i]);
+    } else {
+      m_pair_cache.Store(colB.entity, colA.entity, Vector2Subtract(posA, posB), colB.dimensions,
+                         colA.dimensions, m_pair_touching[i]);
+    }
+
+    if (!m_pair_touching[i]) {
+      continue;
+    }
+
+    // Bodies bounce off each other instead of dealing damage
+    const auto bodyA = m_bodies.Get(colA.entity);
+    const auto bodyB = m_bodies.Get(colB.entity);
+    if (bodyA && bodyB) {
+      if (bodyA->sleeping && bodyB->sleeping) {
+        continue; // resting
+      }
+      const auto renderA = m_renders.Get(colA.entity);
+      const auto renderB = m_renders.Get(colB.entity);
+      const Vector2 delta = Vector2Subtract(posB, posA);
+      const float distance = Vector2Length(delta);
+      const Vector2 normal =
+          distance > 0.f ? Vector2Scale(delta, 1.f / distance) : Vector2{1.f, 0.f};
+      const float penetration = OutlineRadius(colA, renderA, posA, posB) +
+                                OutlineRadius(colB, renderB, posB, posA) - distance;
+      m_body_contacts.push_back({colA.entity, colB.entity, normal, penetration});
+      continue;
+    }
+
+    // RECTANGLES are our Spaceship or its MiningBeam (weapon), they only hit 1 body per frame
+    if ((Shape::RECTANGLE == colA.shape && colA.collided_with.has_value()) ||
+        (Shape::RECTANGLE == colB.shape && colB.collided_with.has_value())) {
+      continue;
+    }
+
+    colA.collided_with = colB.entity;
+    colB.collided_with = colA.entity;
+  }
+
+  m_pair_cache.EndFrame();
+}
+
+// Impulse solver over the body contacts found by CollisionDetectionSystem
+void Registry::BodySolver() {
+  PROFILE_SCOPE("BodySolver");
+  m_solver.Clear();
+  m_solver_bodies.clear();
+  m_solver_index.assign(m_colliders.dense.size(), UINT32_MAX);
+
+  // Solver index of an entity's body, added on first use
+  auto solverIndex = [this](Entity entity) {
+    uint32_t &index = m_solver_index[m_colliders.sparse[entity]];
+    if (index == UINT32_MAX) {
+      const auto velocity = m_velocities.Get(entity);
+      const float radius = m_colliders.Get(entity)->dimensions.x;
+      m_solver_bodies.push_back(entity);
+      index = m_solver.AddBody(velocity ? velocity->value : Vector2{0.f, 0.f},
+                               radius > 0.f ? 1.f / (radius * radius) : 0.f);
+    }
+    return index;
+  };
+
+  for (const auto &contact : m_body_contacts) {
+    const uint32_t a = solverIndex(contact.a);
+    const uint32_t b = solverIndex(contact.b);
+    const float restitution =
+        std::min(m_bodies.Get(contact.a)->restitution, m_bodies.Get(contact.b)->restitution);
+    m_solver.AddContact(a, b, contact.normal, contact.penetration, restitution);
+  }
+
+  m_solver.Solve(SOLVER_ITERATIONS);
+
+  for (uint32_t i = 0; i < m_solver_bodies.size(); i++) {
+    const Entity entity = m_solver_bodies[i];
+    auto velocity = m_velocities.Get(entity);
+    auto pos = m_positions.Get(entity);
+    auto body = m_bodies.Get(entity);
+    body->touching = true;
+    if (velocity) {
+      const Vector2 change = Vector2Subtract(m_solver.Velocity(i), velocity->value);
+      velocity->value = m_solver.Velocity(i);
+      if (body->sleeping && Vector2Length(change) > WAKE_SPEED) {
+        body->sleeping = false;
+        body->still_frames = 0;
+      }
+    }
+    pos->value = Vector2Add(pos->value, m_solver.Correction(i));
+  }
+
+  // Sleeping: only bodies resting against another, a slow drifter keeps drifting
+  for (auto &body : m_bodies.dense) {
+    const bool touching = body.touching;
+    body.touching = false;
+    if (body.sleeping) {
+      continue;
+    }
+    auto velocity = m_velocities.Get(body.entity);
+    if (touching && (!velocity || Vector2Length(velocity->value) < SLEEP_SPEED)) {
+      if (++body.still_frames >= SLEEP_FRAMES) {
+        body.sleeping = true;
+        if (velocity) {
+          velocity->value = {0.f, 0.f};
         }
       }
+    } else {
+      body.still_frames = 0;
     }
   }
 }
 
 void Registry::CollisionResolutionSystem() {
+  PROFILE_SCOPE("CollisionResolutionSystem");
+  BodySolver();
+
   for (auto &collider : m_colliders.dense) {
     if (collider.collided_with.has_value()) {
       auto health = m_healths.Get(collider.entity);
@@ -172,14 +385,10 @@ void Registry::CollisionResolutionSystem() {
           health->value = 0;
         }
 
-        // Need to add Bounce physics
-        // Need to know: pos and dir ???
-        // auto pos = positions.Get(collider.entity);
-        // Add<ForceComponent>(collider.entity, -10.f, -10.f);
       }
 
       // generate particles
-      if (Shape::CIRCLE == collider.shape) {
+      if (collider.IsRound()) {
         // Randomize
         auto meteor_vel = Get<VelocityComponent>(collider.entity);
         auto pos = Get<PositionComponent>(collider.entity);
@@ -188,15 +397,16 @@ void Registry::CollisionResolutionSystem() {
         dir.x = dir.x < 0 ? -1.f : 1.f;
         dir.y = dir.y < 0 ? -1.f : 1.f;
 
-        std::uniform_real_distribution<float> rnd_vel_y(5.f,10.f);
-        std::uniform_real_distribution<float> rnd_vel_x(5.f,10.f);
+        auto &rng = Random::Get(Random::PARTICLES);
         // Generate particle -- NO Emitter for now ...
         Entity particle = CreateEntity();
         Add<RenderComponent>(particle, Layer::GROUND, Shape::ELLIPSE, BLACK, 5.f, 5.f);
         Add<HealthComponent>(particle, 10.f);
         Add<PositionComponent>(particle, pos->value.x, pos->value.y);
-        Add<VelocityComponent>(particle, meteor_vel->value.y + dir.y * rnd_vel_y(gen),
-                               meteor_vel->value.x + dir.x * rnd_vel_x(gen));
+        const float vel_y = rng.Float(5.f, 10.f);
+        const float vel_x = rng.Float(5.f, 10.f);
+        Add<VelocityComponent>(particle, meteor_vel->value.y + dir.y * vel_y,
+                               meteor_vel->value.x + dir.x * vel_x);
         Add<ParticleComponent>(particle, pos->entity);
       }
 
@@ -206,6 +416,13 @@ void Registry::CollisionResolutionSystem() {
 }
 
 void Registry::UISystem() {
+  m_render_list.Clear();
+  UISystem(m_render_list);
+  m_render_list.Submit();
+}
+
+void Registry::UISystem(RenderList &out) {
+  PROFILE_SCOPE("UISystem");
   for (auto &widget : m_widgets.dense) {
     auto widgetPos = m_positions.Get(widget.entity);
 
@@ -226,8 +443,9 @@ void Registry::UISystem() {
       const auto state = m_stateValues.Get(widget.entity);
       if (state) {
         std::visit(
-            [&widgetPos, &widget](auto &&val) {
-              DrawRectangle(widgetPos->value.x, widgetPos->value.y, val * 10, 20, widget.color);
+            [&out, &widgetPos, &widget](auto &&val) {
+              out.DrawRectangle(widgetPos->value, {static_cast<float>(val * 10), 20.f},
+                                widget.color);
             },
             state->value);
       }
@@ -249,6 +467,15 @@ struct {
 } compareLayer;
 
 void Registry::RenderSystem() {
+  auto &platform = Platform::Get();
+  m_render_list.Clear();
+  RenderSystem(m_render_list, {static_cast<float>(platform.GetScreenWidth()),
+                               static_cast<float>(platform.GetScreenHeight())});
+  m_render_list.Submit();
+}
+
+void Registry::RenderSystem(RenderList &out, Vector2 screen) {
+  PROFILE_SCOPE("RenderSystem");
   if (!m_renders_sorted) {
     // Sort by Layer
     std::sort(m_renders.dense.begin(), m_renders.dense.end(), compareLayer);
@@ -260,49 +487,56 @@ void Registry::RenderSystem() {
     // TODO: sort sprites
   }
 
+  // World space from here to the texts
+  Rectangle view{0.f, 0.f, screen.x, screen.y};
+  if (m_camera) {
+    out.BeginMode2D(*m_camera);
+    view = {m_camera->target.x - m_camera->offset.x / m_camera->zoom,
+            m_camera->target.y - m_camera->offset.y / m_camera->zoom, view.width / m_camera->zoom,
+            view.height / m_camera->zoom};
+  }
+  // Only with a camera, without one everything is assumed on screen as before
+  auto outOfView = [&](const Vector2 &at, float extent) {
+    return m_camera && (at.x + extent < view.x || at.x - extent > view.x + view.width ||
+                        at.y + extent < view.y || at.y - extent > view.y + view.height);
+  };
+
   // SHAPES
   for (auto &render : m_renders.dense) {
     const auto pos = m_positions.Get(render.entity);
     if (render.IsVisible()) {
+      const Vector2 at = Interpolate(*pos);
+      // Reach from the anchor: outline radius for meteors, the longer side otherwise
+      const float extent = Shape::METEOR == render.shape
+                               ? render.dimensions.x + render.dimensions.y
+                               : std::max(render.dimensions.x, render.dimensions.y);
+      if (outOfView(at, extent)) {
+        continue;
+      }
       if (Shape::RECTANGLE == render.shape) {
-        DrawRectangleLines(pos->value.x, pos->value.y, render.dimensions.x, render.dimensions.y,
-                           render.color);
-        // DrawRectangle(pos->value.x + 1.f, pos->value.y + 1.f,
-        //               render.dimensions.x - 2.f, render.dimensions.y - 2.f,
-        //               RAYWHITE);
+        out.DrawRectangleLines(at, render.dimensions, render.color);
       } else if (Shape::METEOR == render.shape) {
-        Vector2 center{pos->value.x, pos->value.y};
-
         // ==== METEORS ====
-        const auto &values = render.noise_values;
-        const float two_pi_count = 2.f * PI / values.size();
-
-        // TODO: make more performant
-        for (int i = 0; i < values.size(); i++) {
-          const int next = (i + 1) % values.size();
-          const float radius[2]{render.dimensions.x + values[i],
-                                render.dimensions.x + values[next]};
-          const float angle[2]{i * two_pi_count, next * two_pi_count};
-          const Vector2 coeff[2]{
-              {center.x + cosf(angle[0]) * radius[0], center.y + sinf(angle[0]) * radius[0]},
-              {center.x + cosf(angle[1]) * radius[1], center.y + sinf(angle[1]) * radius[1]}};
-
-          // DrawLineV(coeff[0], coeff[1], render.color); // TRANSPARENT
-          DrawTriangle(center, coeff[1], coeff[0], render.color); // SOLID
+        const float *values = MeteorShapes::Offsets(render.profile);
+        const float amplitude = render.dimensions.y;
+        const float two_pi_count = 2.f * PI / MeteorShapes::POINT_COUNT;
+
+        Vector2 outline[MeteorShapes::POINT_COUNT];
+        for (int i = 0; i < MeteorShapes::POINT_COUNT; i++) {
+          const float radius = render.dimensions.x + amplitude * values[i];
+          const float angle = i * two_pi_count;
+          outline[i] = {at.x + cosf(angle) * radius, at.y + sinf(angle) * radius};
         }
+        out.DrawTriangleFan(at, outline, MeteorShapes::POINT_COUNT, render.color); // SOLID
 
       } else if (Shape::LINE == render.shape) {
-        DrawLine(pos->value.x, pos->value.y, pos->value.x + render.dimensions.x,
-                 pos->value.y + render.dimensions.y, render.color);
+        out.DrawLine(at, {at.x + render.dimensions.x, at.y + render.dimensions.y}, render.color);
       } else if (Shape::ELLIPSE == render.shape) {
-        DrawEllipseLines(pos->value.x, pos->value.y, render.dimensions.x, render.dimensions.y,
-                         render.color);
+        out.DrawEllipseLines(at, render.dimensions.x, render.dimensions.y, render.color);
       } else if (Shape::CIRCLE == render.shape) {
-        DrawCircle(pos->value.x, pos->value.y, render.dimensions.x, render.color);
-        // DrawCircle(pos->value.x, pos->value.y, 10.f, render.color);
+        out.DrawCircle(at, render.dimensions.x, render.color);
       } else if (Shape::RECTANGLE_SOLID == render.shape) {
-        DrawRectangle(pos->value.x, pos->value.y, render.dimensions.x, render.dimensions.y,
-                      render.color);
+        out.DrawRectangle(at, render.dimensions, render.color);
       }
       // TODO: add more...
     }
@@ -310,42 +544,38 @@ void Registry::RenderSystem() {
 
   // SPRITES
   for (auto &sprite : m_sprites.dense) {
-    const auto pos = m_positions.Get(sprite.entity);
-    // Anchor point is center of texture
-    // DrawTexture(sprite.texture, pos->value.x - sprite.texture.width / 2.f,
-    //             pos->value.y - sprite.texture.height / 2.f, WHITE);
-
-    // DrawTexture(sprite.texture, pos->value.x, pos->value.y, WHITE);
-    DrawTextureEx(sprite.texture, {pos->value.x, pos->value.y}, 0, sprite.scale, WHITE);
-
-    // Rectangle source{0, 0, (float)sprite.texture.width, (float)sprite.texture.height};
-    // Rectangle dest{pos->value.x, pos->value.y, (float)sprite.texture.width,
-    //                (float)sprite.texture.height};
-    // DrawTexturePro(sprite.texture, source, dest,
-    //                {sprite.texture.width / 2.f, sprite.texture.height / 2.f}, 0, WHITE);
+    const Vector2 at = Interpolate(*m_positions.Get(sprite.entity));
+    if (outOfView(at, sprite.scale * std::max(sprite.texture.width, sprite.texture.height))) {
+      continue;
+    }
+    // Anchor point is the top left corner of the texture
+    out.DrawTextureEx(sprite.texture, at, sprite.scale, WHITE);
   }
 
-  // DEBUG
-  // for (auto &collider : m_colliders.dense) {
-  //   const auto pos = m_positions.Get(collider.entity);
-  //   if (Shape::CIRCLE == collider.shape) {
-  //     DrawCircleLines(pos->value.x, pos->value.y, collider.dimensions.x, GREEN);
-  //   } else if (Shape::RECTANGLE == collider.shape) {
-  //     DrawRectangleLines(pos->value.x, pos->value.y, collider.dimensions.x,
-  //     collider.dimensions.y,
-  //                        GREEN);
-  //   }
-  // }
+  if (m_camera) {
+    out.EndMode2D();
+  }
 
   // TEXTS
   for (const auto &text : m_texts.dense) {
     const auto pos = m_positions.Get(text.entity);
-    DrawText(text.value.c_str(), pos->value.x, pos->value.y, 20, text.color);
+    out.DrawText(text.value, pos->value, 20, text.color);
   }
 }
 
 // Only 1 input component supported for now
+void Registry::SampleInput() {
+  auto &platform = Platform::Get();
+  m_controls.right = platform.IsKeyDown(KEY_RIGHT);
+  m_controls.left = platform.IsKeyDown(KEY_LEFT);
+  m_controls.up = platform.IsKeyDown(KEY_UP);
+  m_controls.down = platform.IsKeyDown(KEY_DOWN);
+  m_controls.fire = platform.IsKeyDown(KEY_SPACE);
+}
+
 void Registry::InputSystem() {
+  PROFILE_SCOPE("InputSystem");
+
   const auto &input = m_inputs.dense[0];
   const Entity spaceship = input.entity;
 
@@ -353,9 +583,9 @@ void Registry::InputSystem() {
   auto force = Get<ForceComponent>(spaceship);
   if (force) {
     // Simulate drag by applying force inc/dec per dt and limiting
-    if (IsKeyDown(KEY_RIGHT)) {
+    if (m_controls.right) {
       force->value.x += input.push_force_step;
-    } else if (IsKeyDown(KEY_LEFT)) {
+    } else if (m_controls.left) {
       force->value.x -= input.push_force_step;
     } else if (force->value.x > input.push_force_step_half) { // correction
       force->value.x -= input.push_force_step;
@@ -365,9 +595,9 @@ void Registry::InputSystem() {
       force->value.x = 0.f;
     }
 
-    if (IsKeyDown(KEY_UP)) {
+    if (m_controls.up) {
       force->value.y -= input.push_force_step;
-    } else if (IsKeyDown(KEY_DOWN)) {
+    } else if (m_controls.down) {
       force->value.y += input.push_force_step;
     } else if (force->value.y > input.push_force_step_half) { // correction
       force->value.y -= input.push_force_step;
@@ -390,11 +620,12 @@ void Registry::InputSystem() {
   auto &weapon = m_weapons.dense[0];
   const Entity miningBeam = weapon.entity;
 
-  if (IsKeyDown(KEY_SPACE)) {
+  if (m_controls.fire) {
     if (!weapon.isFiring) {
       weapon.isFiring = true;
       weapon.firingDuration = 0;
-      Add<ColliderComponent>(miningBeam, Game::WEAPON_SIZE, 10.f);
+      Add<ColliderComponent>(miningBeam, Game::WEAPON_SIZE, 10.f, CollisionLayer::BEAM,
+                             CollisionLayer::BEAM_MASK);
 
       // Enable Emitter
       // auto emitter = Get<EmitterComponent>(miningBeam);
@@ -441,6 +672,7 @@ void Registry::InputSystem() {
 }
 
 void Registry::ParticleSystem() {
+  PROFILE_SCOPE("ParticleSystem");
   for (auto &emitter : m_emitters.dense) {
     if (!emitter.active) {
       continue;
@@ -454,38 +686,35 @@ void Registry::ParticleSystem() {
       // Generate Particles (emitter is the origin)
       auto emitter_pos = Get<PositionComponent>(emitter.entity);
 
-      // Randomizers
-      std::uniform_int_distribution<int> number(3, 5);
-      std::uniform_real_distribution<float> rnd_offset(-5.f, 5.f);
-      std::uniform_real_distribution<float> rnd_velocity(emitter.particle_velocity.y - 5.f,
-                                                         emitter.particle_velocity.y);
-
       // multiple particles -> SEGFAULT
-      // for (int i = 0; i < number(gen); i++) {
+      // auto &rng = Random::Get(Random::PARTICLES);
+      // for (int i = 0, count = rng.Int(3, 5); i < count; i++) {
       // Entity particle = CreateEntity();
       // fmt::println("Generated: {}", particle);
       // Add<RenderComponent>(particle, Layer::GROUND, emitter.particle_shape, MAROON, 0.f, 20.f);
       // Add<HealthComponent>(particle, emitter.particle_lifetime);
       // Add<PositionComponent>(particle, emitter_pos->value.x, emitter_pos->value.y);
-      // Add<VelocityComponent>(particle, rnd_velocity(gen), emitter.particle_velocity.y);
+      // Add<VelocityComponent>(particle,
+      //                        rng.Float(emitter.particle_velocity.y - 5.f,
+      //                                  emitter.particle_velocity.y),
+      //                        emitter.particle_velocity.y);
       // // connect particle with emitter, add position offset
-      // Add<ParticleComponent>(particle, emitter.entity, rnd_offset(gen));
+      // Add<ParticleComponent>(particle, emitter.entity, rng.Float(-5.f, 5.f));
       // }
     }
   }
 
-  // TODO: check if this should be done at a later step i.e a separate System
-  for (auto &particle : m_particles.dense) {
+  // Retired particles are deleted by ParticleCleanupSystem on the next step
+  ParallelEach<ParticleComponent, HealthComponent>([](ParticleComponent &particle,
+                                                      HealthComponent &health) {
     if (!particle.active) {
-      DeleteEntity(particle.entity);
-      continue;
+      return;
     }
 
     // update health
-    auto health = Get<HealthComponent>(particle.entity);
-    --health->value;
+    --health.value;
 
-    if (health->value <= 0.f) {
+    if (health.value <= 0.f) {
       particle.active = false;
     }
 
@@ -500,21 +729,97 @@ void Registry::ParticleSystem() {
     //     pos->value.y = emitter_pos->value.y;
     //   }
     // }
+  });
+}
+
+// Deletes the particles ParticleSystem retired, kept apart so aging never changes the entities
+void Registry::ParticleCleanupSystem() {
+  PROFILE_SCOPE("ParticleCleanupSystem");
+  // Backwards: DeleteEntity moves the last particle, already visited, into the freed slot
+  for (size_t i = m_particles.dense.size(); i-- > 0;) {
+    if (!m_particles.dense[i].active) {
+      DeleteEntity(m_particles.dense[i].entity);
+    }
   }
 }
 
 void Registry::ResetSystem() { m_forces.Reset(); }
 
+Vector2 Registry::Interpolate(const PositionComponent &pos) const {
+  return Vector2Lerp(pos.previous, pos.value, m_interpolation);
+}
+
 void Registry::Debug() {
+  auto &platform = Platform::Get();
+
   int positions = m_positions.dense.size();
   int renders = m_renders.dense.size();
   int particles = m_particles.dense.size();
   int entities = m_entities.size();
 
-  DrawText(TextFormat("e:%i", entities), 10, 60, 20, BLACK);
-  DrawText(TextFormat("p:%i", positions), 10, 80, 20, BLACK);
-  DrawText(TextFormat("r:%i", renders), 10, 100, 20, BLACK);
-  DrawText(TextFormat("cnt:%i", ThreadSafeIdGenerator::getCurrentId()), 10, 120, 20, BLACK);
-  DrawText(TextFormat("pts:%i", particles), 10, 140, 20, BLACK);
+  platform.DrawText(TextFormat("e:%i", entities), 10, 60, 20, BLACK);
+  platform.DrawText(TextFormat("p:%i", positions), 10, 80, 20, BLACK);
+  platform.DrawText(TextFormat("r:%i", renders), 10, 100, 20, BLACK);
+  platform.DrawText(TextFormat("cnt:%i", ThreadSafeIdGenerator::getCurrentId()), 10, 120, 20,
+                    BLACK);
+  platform.DrawText(TextFormat("pts:%i", particles), 10, 140, 20, BLACK);
+
+  // POOLS: live/capacity components, peak, KiB held
+  int y = 165;
+  for (const auto &pool : MemoryStats()) {
+    const PoolStats &stats = pool.stats;
+    platform.DrawText(TextFormat("%-12s %5zu/%-5zu peak %5zu %7.1f KiB", pool.name, stats.live,
+                                 stats.capacity, stats.high_water, stats.capacity_bytes / 1024.),
+                      10, y, 10, DARKGRAY);
+    y += 12;
+  }
+}
+
+std::vector<Registry::PoolMemory> Registry::MemoryStats() const {
+  std::vector<PoolMemory> pools;
+  ForEachPool(*this, [&pools](const char *name, const auto &pool) {
+    pools.push_back({name, pool.Stats()});
+  });
+  return pools;
+}
+
+void Registry::CaptureSnapshots() {
+  PROFILE_SCOPE("CaptureSnapshots");
+  m_position_snapshot.Capture(m_positions, [](const PositionComponent &pos) {
+    return PositionRecord{pos.value, pos.previous, pos.entity};
+  });
+  m_render_snapshot.Capture(m_renders, [](const RenderComponent &render) {
+    return RenderRecord{render.color, render.dimensions, render.entity, render.shape,
+                        render.priority, render.profile};
+  });
+  m_health_snapshot.Capture(m_healths, [](const HealthComponent &health) {
+    return HealthRecord{health.value, health.entity};
+  });
+}
+
+void Registry::SwapSnapshots() {
+  m_position_snapshot.Swap();
+  m_render_snapshot.Swap();
+  m_health_snapshot.Swap();
+}
+
+void Registry::ShrinkToFit() {
+  ForEachPool(*this, [](const char *name, auto &pool) { pool.ShrinkToFit(INITIAL_ELEMENTS); });
+  std::vector<Entity> entities(m_entities); // as long as it must be, then what Reserve asked for
+  entities.reserve(m_entities_reserved);
+  m_entities.swap(entities);
+}
+
+void Registry::PoolChecksums(uint64_t (&out)[Resource::POOL_COUNT]) const {
+  int index = 0;
+  ForEachPool(*this, [&out, &index](const char *name, const auto &pool) {
+    // FNV-1a over the dense array as bytes, strings and other owners only by their handles
+    const auto *bytes = reinterpret_cast<const unsigned char *>(pool.dense.data());
+    uint64_t hash = 14695981039346656037ull ^ pool.dense.size();
+    for (size_t i = 0; i < pool.dense.size() * sizeof(pool.dense[0]); i++) {
+      hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    out[index++] = hash;
+  });
 }
 } // namespace ECS
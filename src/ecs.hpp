@@ -1,17 +1,27 @@
 #ifndef ECS_H
 #define ECS_H
 
-#include "FastNoiseLite.h"
+#include "collision.hpp"
 #include "fmt/core.h"
 #include "fmt/format.h"
+#include "jobs.hpp"
+#include "meteor-shapes.hpp"
+#include "physics.hpp"
+#include "platform.hpp"
+#include "pool-snapshot.hpp"
+#include "random.hpp"
 #include "raylib.h"
+#include "render-list.hpp"
 #include "sparse-set.hpp"
+#include <algorithm>
 #include <atomic>
+#include <cstddef>
 #include <cstdint>
+#include <numeric>
 #include <optional>
-#include <random>
 #include <string>
 #include <string_view>
+#include <tuple>
 #include <type_traits>
 #include <utility>
 #include <variant>
@@ -29,12 +39,6 @@ using Entity = size_t;
 // template <typename T>
 // using ComponentGroups = std::unordered_map<ComponentMask, SparseSet<T>>;
 
-namespace {
-static constexpr float NOISE_SCALE = 0.1f;
-static inline FastNoiseLite s_noise;
-static inline std::random_device s_rd;
-} // namespace
-
 class ThreadSafeIdGenerator {
 public:
   // Get next unique ID
@@ -58,6 +62,8 @@ enum class Shape {
   // Only for RenderComponents
   RECTANGLE_SOLID,
   ELLIPSE,
+
+  // RenderComponents, ColliderComponents use the render's noise profile
   METEOR,
 };
 enum class UIElement {
@@ -66,12 +72,49 @@ enum class UIElement {
 };
 enum class Layer : uint8_t { SUB, GROUND, SKY };
 
+// What a system reads or writes, see Schedule: one bit per pool, in ForEachPool order, then the
+// state that is not a pool
+using Access = uint32_t;
+namespace Resource {
+constexpr Access POSITIONS = 1 << 0;
+constexpr Access VELOCITIES = 1 << 1;
+constexpr Access COLLIDERS = 1 << 2;
+constexpr Access TEXTS = 1 << 3;
+constexpr Access FORCES = 1 << 4;
+constexpr Access RENDERS = 1 << 5;
+constexpr Access SPRITES = 1 << 6;
+constexpr Access WIDGETS = 1 << 7;
+constexpr Access HEALTHS = 1 << 8;
+constexpr Access DMGS = 1 << 9;
+constexpr Access STATE_VALUES = 1 << 10;
+constexpr Access WEAPONS = 1 << 11;
+constexpr Access INPUTS = 1 << 12;
+constexpr Access EMITTERS = 1 << 13;
+constexpr Access PARTICLES = 1 << 14;
+constexpr Access BODIES = 1 << 15;
+constexpr int POOL_COUNT = 16;
+
+constexpr Access ENTITIES = 1 << 16; // creating or deleting entities, adding or removing components
+constexpr Access CONTACTS = 1 << 17; // collision state: pair cache, body contacts
+constexpr Access PLATFORM = 1 << 18; // raylib, systems using it run on the main thread
+constexpr Access RANDOM = 1 << 19;   // Random's streams
+constexpr Access USER = 1 << 20;     // first bit left for state outside the registry
+} // namespace Resource
+
+#ifdef MINOIDS_CHECK_ACCESS
+// Reports `resources` the system running on this thread did not declare (system-schedule.cpp)
+void CheckAccess(Access resources, bool write);
+#else
+inline void CheckAccess(Access resources, bool write) {}
+#endif
+
 // static ComponentGroups groups; // Mask -> SparseSet<Components>
 
 struct PositionComponent {
   Vector2 value;
+  Vector2 previous; // value before the last PositionSystem, for render interpolation
   Entity entity;
-  explicit PositionComponent(float x, float y) : value(Vector2{x, y}) {}
+  explicit PositionComponent(float x, float y) : value(Vector2{x, y}), previous(value) {}
   ~PositionComponent() = default;
   PositionComponent(const PositionComponent &other) = delete;
   PositionComponent(PositionComponent &&other) noexcept = default;
@@ -89,17 +132,44 @@ struct VelocityComponent {
 };
 
 struct ColliderComponent {
-  Vector2 dimensions; // width/height or radius based on shape
+  Vector2 dimensions; // width/height or radius or radius/noise_amp based on shape
   Entity entity;
   Shape shape;
+  CollisionMask category; // what this collider is
+  CollisionMask mask;     // what this collider reacts to
   std::optional<Entity> collided_with;
-  explicit ColliderComponent(float width, float height)
-      : dimensions({width, height}), shape(Shape::RECTANGLE) {}
-  explicit ColliderComponent(float radius) : dimensions({radius, radius}), shape(Shape::CIRCLE) {}
+  explicit ColliderComponent(float width, float height, CollisionMask category, CollisionMask mask)
+      : dimensions({width, height}), shape(Shape::RECTANGLE), category(category), mask(mask) {}
+  explicit ColliderComponent(float radius, CollisionMask category, CollisionMask mask)
+      : dimensions({radius, radius}), shape(Shape::CIRCLE), category(category), mask(mask) {}
+  explicit ColliderComponent(Shape shape /* Meteor */, float radius, float noise_amplitude,
+                             CollisionMask category, CollisionMask mask)
+      : dimensions({radius, noise_amplitude}), shape(shape), category(category), mask(mask) {}
   ~ColliderComponent() = default;
   ColliderComponent(const ColliderComponent &other) = delete;
   ColliderComponent(ColliderComponent &&other) noexcept = default;
   ColliderComponent &operator=(ColliderComponent &&rhs) noexcept = default;
+
+  bool IsRound() const { return Shape::CIRCLE == shape || Shape::METEOR == shape; }
+
+  // Radius of the circle enclosing a round collider
+  float BoundingRadius() const {
+    return Shape::METEOR == shape ? dimensions.x + dimensions.y : dimensions.x;
+  }
+};
+
+// Rigid body for round colliders, mass comes from the collider's radius
+struct BodyComponent {
+  float restitution;
+  Entity entity;
+  int still_frames = 0; // consecutive frames in a contact and slower than SLEEP_SPEED
+  bool sleeping = false;
+  bool touching = false; // in a contact this frame
+  explicit BodyComponent(float restitution) : restitution(restitution) {}
+  ~BodyComponent() = default;
+  BodyComponent(const BodyComponent &other) = delete;
+  BodyComponent(BodyComponent &&other) noexcept = default;
+  BodyComponent &operator=(BodyComponent &&rhs) noexcept = default;
 };
 
 // TODO: merge with UIComponent
@@ -146,7 +216,7 @@ struct RenderComponent {
   Entity entity;
   Shape shape;
   Layer priority; // for layering
-  std::vector<float> noise_values;
+  MeteorShapes::Handle profile = 0; // METEOR outline
 
   // Contructors - TODO: constraint shapes
   RenderComponent(Layer priority, Shape shape /*Rectangle | Line */, Color color, float width,
@@ -157,19 +227,9 @@ struct RenderComponent {
       : priority(priority), color(color), dimensions({radius, radius}), shape(shape) {}
 
   RenderComponent(Layer priority, Shape shape /* Meteor */, Color color, float radius,
-                  float noise_amplitude, int point_count)
-      : priority(priority), color(color), dimensions({radius, noise_amplitude}), shape(shape) {
-
-    s_noise.SetNoiseType(FastNoiseLite::NoiseType_Perlin);
-    s_noise.SetFrequency(NOISE_SCALE);
-    s_noise.SetSeed(s_rd());
-
-    noise_values.reserve(point_count);
-    for (int i = 0; i < point_count; i++) {
-      float noiseValue = s_noise.GetNoise<float>(i, 0.0f);
-      noise_values.push_back(noiseValue * noise_amplitude);
-    }
-  }
+                  float noise_amplitude, MeteorShapes::Handle profile)
+      : priority(priority), color(color), dimensions({radius, noise_amplitude}), shape(shape),
+        profile(profile) {}
 
   ~RenderComponent() = default;
   RenderComponent(const RenderComponent &other) = delete;
@@ -196,18 +256,18 @@ struct SpriteComponent {
 
   explicit SpriteComponent(Layer priority, std::string filename)
       : priority(priority), scale(1.f) {
-    texture = LoadTexture(filename.c_str());
+    texture = Platform::Get().LoadTexture(filename.c_str());
     m_owns_texture = true;
   }
   explicit SpriteComponent(Layer priority, std::string filename, float scale)
       : priority(priority), scale(scale) {
-    texture = LoadTexture(filename.c_str());
+    texture = Platform::Get().LoadTexture(filename.c_str());
     m_owns_texture = true;
   }
 
   ~SpriteComponent() {
     if (m_owns_texture) {
-      UnloadTexture(texture);
+      Platform::Get().UnloadTexture(texture);
     }
   }
 
@@ -224,7 +284,7 @@ struct SpriteComponent {
   SpriteComponent &operator=(SpriteComponent &&rhs) noexcept {
     if (this != &rhs) {
       if (m_owns_texture) {
-        UnloadTexture(texture);
+        Platform::Get().UnloadTexture(texture);
       } else {
         rhs.m_owns_texture = false;
         m_owns_texture = true;
@@ -330,6 +390,27 @@ struct ParticleComponent {
   ParticleComponent &operator=(ParticleComponent &&rhs) noexcept = default;
 };
 
+// What the Registry's snapshots keep of a component, see CaptureSnapshots
+struct PositionRecord {
+  Vector2 value;
+  Vector2 previous;
+  Entity entity;
+};
+
+struct RenderRecord {
+  Color color;
+  Vector2 dimensions;
+  Entity entity;
+  Shape shape;
+  Layer priority;
+  MeteorShapes::Handle profile;
+};
+
+struct HealthRecord {
+  float value;
+  Entity entity;
+};
+
 // Used for entities isolation i.e per scene
 class Registry {
 public:
@@ -340,19 +421,76 @@ public:
 
   void Init();
   void DeleteEntity(Entity entity);
+  // Draws now: records into a list of its own and submits it, main thread only
   void RenderSystem();
+  // Appends shapes, sprites and texts to `out`, culled to a `screen` sized view of the camera
+  void RenderSystem(RenderList &out, Vector2 screen);
   void ResetSystem();
   void PositionSystem();
   void UISystem();
+  void UISystem(RenderList &out);
+  // Reads the keys InputSystem acts on, main thread once per frame. InputSystem itself does not
+  // touch the Platform, so it can run on a worker.
+  void SampleInput();
   void InputSystem();
   void CollisionDetectionSystem();
   void CollisionResolutionSystem();
   void ParticleSystem();
+  void ParticleCleanupSystem();
 
   void Debug();
 
+  struct PoolMemory {
+    const char *name;
+    PoolStats stats;
+  };
+  // One entry per component pool
+  std::vector<PoolMemory> MemoryStats() const;
+  // Trims every pool to its live components, but not below the initial reservation, so
+  // gameplay does not grow them again. Between frames, e.g. when the game pauses after a burst.
+  void ShrinkToFit();
+  // Room for `count` more entities with each of the `T` components, kept by ShrinkToFit. At load,
+  // so spawning up to that many mid-level does not allocate.
+  template <typename... T> void Reserve(size_t count) {
+    (Pool<T>().Reserve(Pool<T>().dense.size() + count), ...);
+    m_entities_reserved = std::max(m_entities_reserved, m_entities.size() + count);
+    m_entities.reserve(m_entities_reserved);
+  }
+  // One hash of the raw components per pool, in Resource order, for Schedule's access check
+  void PoolChecksums(uint64_t (&out)[Resource::POOL_COUNT]) const;
+
+  // Where RenderSystem draws positions: 0 = previous tick, 1 = current tick
+  void SetInterpolation(float alpha) { m_interpolation = alpha; }
+  // Where RenderSystem draws `entity` this frame, which must have a position
+  Vector2 RenderPosition(Entity entity) { return Interpolate(*m_positions.Get(entity)); }
+
+  // PositionSystem wraps positions around [0, size], the screen until set
+  void SetWorldSize(Vector2 size) { m_world_size = size; }
+  // RenderSystem draws shapes and sprites through `camera` and skips those out of its view,
+  // texts stay in screen space
+  void SetCamera(const Camera2D &camera) { m_camera = camera; }
+
+  // SNAPSHOTS: positions, renders and healths as of the last SwapSnapshots, for readers running
+  // while the systems change the pools, e.g. a debug view drawn during the next simulation.
+  // Fills the back copies, while no system runs
+  void CaptureSnapshots();
+  // Frame boundary: the captured copies become the ones Snapshot returns. Nothing may read them
+  // or capture meanwhile.
+  void SwapSnapshots();
+  // PositionComponent, RenderComponent or HealthComponent
+  template <typename T> const auto &Snapshot() const {
+    if constexpr (std::is_same_v<T, PositionComponent>) {
+      return m_position_snapshot;
+    } else if constexpr (std::is_same_v<T, RenderComponent>) {
+      return m_render_snapshot;
+    } else if constexpr (std::is_same_v<T, HealthComponent>) {
+      return m_health_snapshot;
+    }
+  }
+
   // TEMPLATES
   template <typename T, typename... Args> bool Add(Entity entity, Args &&...args) {
+    CheckAccess(Resource::ENTITIES, true);
     T component{std::forward<Args>(args)...};
 
     if constexpr (std::is_same_v<T, PositionComponent>) {
@@ -386,12 +524,15 @@ public:
       return m_emitters.Add(entity, std::move(component));
     } else if constexpr (std::is_same_v<T, ParticleComponent>) {
       return m_particles.Add(entity, std::move(component));
+    } else if constexpr (std::is_same_v<T, BodyComponent>) {
+      return m_bodies.Add(entity, std::move(component));
     }
 
     return false;
   }
 
   template <typename T> void Remove(Entity entity) {
+    CheckAccess(Resource::ENTITIES, true);
     if constexpr (std::is_same_v<T, PositionComponent>) {
       m_positions.Remove(entity);
     } else if constexpr (std::is_same_v<T, VelocityComponent>) {
@@ -422,10 +563,14 @@ public:
       m_emitters.Remove(entity);
     } else if constexpr (std::is_same_v<T, ParticleComponent>) {
       m_particles.Remove(entity);
+    } else if constexpr (std::is_same_v<T, BodyComponent>) {
+      m_bodies.Remove(entity);
     }
   }
 
+  // Checked as a read, what the caller writes through the pointer is checked by the hashes
   template <typename T> T *Get(Entity entity) {
+    CheckAccess(AccessOf<T>(), false);
     if constexpr (std::is_same_v<T, PositionComponent>) {
       return m_positions.Get(entity);
     } else if constexpr (std::is_same_v<T, VelocityComponent>) {
@@ -456,16 +601,118 @@ public:
       return m_emitters.Get(entity);
     } else if constexpr (std::is_same_v<T, ParticleComponent>) {
       return m_particles.Get(entity);
+    } else if constexpr (std::is_same_v<T, BodyComponent>) {
+      return m_bodies.Get(entity);
     }
 
     return nullptr;
   }
 
+  // The pool bit of component T
+  template <typename T> static constexpr Access AccessOf() {
+    using namespace Resource;
+    if constexpr (std::is_same_v<T, PositionComponent>) {
+      return POSITIONS;
+    } else if constexpr (std::is_same_v<T, VelocityComponent>) {
+      return VELOCITIES;
+    } else if constexpr (std::is_same_v<T, ColliderComponent>) {
+      return COLLIDERS;
+    } else if constexpr (std::is_same_v<T, TextComponent>) {
+      return TEXTS;
+    } else if constexpr (std::is_same_v<T, ForceComponent>) {
+      return FORCES;
+    } else if constexpr (std::is_same_v<T, RenderComponent>) {
+      return RENDERS;
+    } else if constexpr (std::is_same_v<T, SpriteComponent>) {
+      return SPRITES;
+    } else if constexpr (std::is_same_v<T, UIComponent>) {
+      return WIDGETS;
+    } else if constexpr (std::is_same_v<T, HealthComponent>) {
+      return HEALTHS;
+    } else if constexpr (std::is_same_v<T, DmgComponent>) {
+      return DMGS;
+    } else if constexpr (std::is_same_v<T, GameStateComponent>) {
+      return STATE_VALUES;
+    } else if constexpr (std::is_same_v<T, WeaponComponent>) {
+      return WEAPONS;
+    } else if constexpr (std::is_same_v<T, InputComponent>) {
+      return INPUTS;
+    } else if constexpr (std::is_same_v<T, EmitterComponent>) {
+      return EMITTERS;
+    } else if constexpr (std::is_same_v<T, ParticleComponent>) {
+      return PARTICLES;
+    } else if constexpr (std::is_same_v<T, BodyComponent>) {
+      return BODIES;
+    }
+    return 0;
+  }
+
+  // Calls f(component, others...) for every T whose entity also has each of Ts, spread over the
+  // workers (see jobs.hpp) in chunks of T's dense array. Chunks start on a cache line and span
+  // at least PARALLEL_CHUNK_BYTES, so workers never write the same line. f may change what it
+  // is given and read what no call writes, it must not add or remove components.
+  //
+  // Taking the chunk index first, f(chunk, component, others...), chunks cover the dense array
+  // in order: outputs kept per chunk and merged by index come out the same on any number of
+  // workers. ParallelChunks<T>() tells how many there are.
+  template <typename T, typename... Ts, typename F> void ParallelEach(F &&f) {
+    CheckAccess((AccessOf<T>() | ... | AccessOf<Ts>()), false);
+    auto &dense = Pool<T>().dense;
+    const size_t first = FirstAlignedIndex<T>();
+    const size_t step = ParallelChunkSize<T>();
+    Jobs::ParallelFor(ParallelChunks<T>(), 1, [&](size_t begin, size_t end) {
+      for (size_t chunk = begin; chunk < end; chunk++) {
+        const size_t from = chunk == 0 ? 0 : first + chunk * step;
+        const size_t to = std::min(dense.size(), first + (chunk + 1) * step);
+        for (size_t i = from; i < to; i++) {
+          T &component = dense[i];
+          const auto others = std::make_tuple(Pool<Ts>().Get(component.entity)...);
+          if ((... || !std::get<Ts *>(others))) {
+            continue;
+          }
+          if constexpr (std::is_invocable_v<F &, size_t, T &, Ts &...>) {
+            f(chunk, component, *std::get<Ts *>(others)...);
+          } else {
+            f(component, *std::get<Ts *>(others)...);
+          }
+        }
+      }
+    });
+  }
+
+  template <typename T> size_t ParallelChunks() {
+    const size_t size = Pool<T>().dense.size();
+    const size_t first_end = FirstAlignedIndex<T>() + ParallelChunkSize<T>();
+    return size <= first_end ? 1 : 1 + (size - first_end + ParallelChunkSize<T>() - 1) /
+                                           ParallelChunkSize<T>();
+  }
+
 private:
+  static constexpr size_t CACHE_LINE = 64;
+  static constexpr size_t PARALLEL_CHUNK_BYTES = 16 * 1024;
+
+  // Components per chunk: a whole number of cache lines, whatever sizeof(T)
+  template <typename T> static constexpr size_t ParallelChunkSize() {
+    const size_t lines = std::lcm(sizeof(T), CACHE_LINE) / sizeof(T);
+    return (PARALLEL_CHUNK_BYTES / sizeof(T) + lines - 1) / lines * lines;
+  }
+
+  // Index of the first T of the dense array starting a cache line, where chunk 1 starts
+  template <typename T> size_t FirstAlignedIndex() {
+    const auto address = reinterpret_cast<uintptr_t>(Pool<T>().dense.data());
+    for (size_t i = 0; i < CACHE_LINE; i++) {
+      if ((address + i * sizeof(T)) % CACHE_LINE == 0) {
+        return i;
+      }
+    }
+    return 0; // never on a line, chunks only keep whole lines apart
+  }
+
   // size_t m_entityCounter = 0;
 
   // TODO: use Tombstoned vector for O(1) delete and element reusability
   std::vector<Entity> m_entities;
+  size_t m_entities_reserved = 0;
 
   SparseSet<PositionComponent> m_positions;
   SparseSet<VelocityComponent> m_velocities;
@@ -482,14 +729,101 @@ private:
   SparseSet<InputComponent> m_inputs;
   SparseSet<EmitterComponent> m_emitters;
   SparseSet<ParticleComponent> m_particles;
+  SparseSet<BodyComponent> m_bodies;
+
+  PoolSnapshot<PositionRecord> m_position_snapshot;
+  PoolSnapshot<RenderRecord> m_render_snapshot;
+  PoolSnapshot<HealthRecord> m_health_snapshot;
+
+  // Calls f(name, pool) for every component pool
+  template <typename Self, typename F> static void ForEachPool(Self &self, F &&f) {
+    f("positions", self.m_positions);
+    f("velocities", self.m_velocities);
+    f("colliders", self.m_colliders);
+    f("texts", self.m_texts);
+    f("forces", self.m_forces);
+    f("renders", self.m_renders);
+    f("sprites", self.m_sprites);
+    f("widgets", self.m_widgets);
+    f("healths", self.m_healths);
+    f("dmgs", self.m_dmgs);
+    f("stateValues", self.m_stateValues);
+    f("weapons", self.m_weapons);
+    f("inputs", self.m_inputs);
+    f("emitters", self.m_emitters);
+    f("particles", self.m_particles);
+    f("bodies", self.m_bodies);
+  }
+
+  template <typename T> SparseSet<T> &Pool() {
+    if constexpr (std::is_same_v<T, PositionComponent>) {
+      return m_positions;
+    } else if constexpr (std::is_same_v<T, VelocityComponent>) {
+      return m_velocities;
+    } else if constexpr (std::is_same_v<T, ColliderComponent>) {
+      return m_colliders;
+    } else if constexpr (std::is_same_v<T, TextComponent>) {
+      return m_texts;
+    } else if constexpr (std::is_same_v<T, ForceComponent>) {
+      return m_forces;
+    } else if constexpr (std::is_same_v<T, RenderComponent>) {
+      return m_renders;
+    } else if constexpr (std::is_same_v<T, SpriteComponent>) {
+      return m_sprites;
+    } else if constexpr (std::is_same_v<T, UIComponent>) {
+      return m_widgets;
+    } else if constexpr (std::is_same_v<T, HealthComponent>) {
+      return m_healths;
+    } else if constexpr (std::is_same_v<T, DmgComponent>) {
+      return m_dmgs;
+    } else if constexpr (std::is_same_v<T, GameStateComponent>) {
+      return m_stateValues;
+    } else if constexpr (std::is_same_v<T, WeaponComponent>) {
+      return m_weapons;
+    } else if constexpr (std::is_same_v<T, InputComponent>) {
+      return m_inputs;
+    } else if constexpr (std::is_same_v<T, EmitterComponent>) {
+      return m_emitters;
+    } else if constexpr (std::is_same_v<T, ParticleComponent>) {
+      return m_particles;
+    } else if constexpr (std::is_same_v<T, BodyComponent>) {
+      return m_bodies;
+    }
+  }
 
   void CleanupEntity(Entity entity);
+  Vector2 Interpolate(const PositionComponent &pos) const;
+  bool MeteorCollision(const ColliderComponent &colA, const ColliderComponent &colB,
+                       const Vector2 &posA, const Vector2 &posB);
+  void BodySolver();
+
+  // Keys down when SampleInput last ran
+  struct Controls {
+    bool right = false;
+    bool left = false;
+    bool up = false;
+    bool down = false;
+    bool fire = false;
+  };
 
   bool m_renders_sorted;
-
-  // ENTROPY
-  std::random_device rd;
-  std::mt19937 gen;
+  float m_interpolation = 1.f;
+  std::optional<Vector2> m_world_size;
+  std::optional<Camera2D> m_camera;
+  Controls m_controls;
+  RenderList m_render_list; // RenderSystem and UISystem drawing now
+
+  // COLLISIONS
+  std::vector<CollisionProxy> m_collision_proxies; // 1-1 with m_colliders.dense
+  Broadphase m_broadphase;
+  Narrowphase m_narrowphase;
+  PairCache m_pair_cache;
+  std::vector<BodyContact> m_body_contacts;
+  ImpulseSolver m_solver;
+  std::vector<Entity> m_solver_bodies;   // solver index -> entity
+  std::vector<uint32_t> m_solver_index; // collider dense index -> solver index
+  std::vector<uint8_t> m_pair_touching; // per broadphase pair
+  std::vector<uint8_t> m_pair_cached;
 };
 
 // template <typename... C> void RegisterComponentGroup() {
@@ -0,0 +1,184 @@
+#include "frame-stats.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+namespace FrameStats {
+
+// Bucket i < SUB_BUCKETS holds i us. Above that every power of two is split in HALF linear
+// buckets, so a bucket is never wider than 1/HALF of its value.
+static constexpr int SUB_BITS = 7;
+static constexpr uint64_t SUB_BUCKETS = 1 << SUB_BITS;
+static constexpr uint64_t HALF = SUB_BUCKETS / 2;
+static constexpr int MAX_BITS = 26; // 67 s, longer frames are clamped
+static constexpr uint64_t MAX_US = (uint64_t{1} << MAX_BITS) - 1;
+static constexpr size_t BUCKETS = (MAX_BITS - SUB_BITS + 2) * HALF;
+static constexpr size_t SCENE_COUNT = static_cast<size_t>(Scene::NEXT_ROUND) + 1;
+
+struct Histogram {
+  uint32_t counts[BUCKETS];
+  uint64_t frames;
+  uint64_t sum_us;
+  uint64_t max_us;
+};
+
+static Histogram s_histograms[SCENE_COUNT][PHASE_COUNT];
+
+// Current frame
+static std::chrono::steady_clock::time_point s_frame_start;
+static std::chrono::steady_clock::time_point s_mark;
+static uint64_t s_phase_us[PHASE_COUNT];
+static bool s_marked[PHASE_COUNT];
+
+static size_t Bucket(uint64_t us) {
+  if (us < SUB_BUCKETS) {
+    return us;
+  }
+  int msb = 63;
+  while (!(us >> msb)) {
+    --msb;
+  }
+  const int shift = msb - SUB_BITS + 1;
+  return shift * HALF + (us >> shift);
+}
+
+// Highest value that lands in the bucket
+static uint64_t BucketValue(size_t bucket) {
+  if (bucket < SUB_BUCKETS) {
+    return bucket;
+  }
+  const size_t shift = bucket / HALF - 1;
+  const uint64_t sub = bucket % HALF + HALF;
+  return ((sub + 1) << shift) - 1;
+}
+
+static void Record(Histogram &histogram, uint64_t us) {
+  us = std::min(us, MAX_US);
+  histogram.counts[Bucket(us)]++;
+  histogram.frames++;
+  histogram.sum_us += us;
+  histogram.max_us = std::max(histogram.max_us, us);
+}
+
+static double Percentile(const Histogram &histogram, double p) {
+  const uint64_t target = std::max<uint64_t>(1, std::ceil(p * histogram.frames));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < BUCKETS; i++) {
+    seen += histogram.counts[i];
+    if (seen >= target) {
+      return std::min(BucketValue(i), histogram.max_us) / 1e3;
+    }
+  }
+  return histogram.max_us / 1e3;
+}
+
+static uint64_t ElapsedUs(std::chrono::steady_clock::time_point from,
+                          std::chrono::steady_clock::time_point to) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(to - from).count();
+}
+
+const char *Name(Phase phase) {
+  switch (phase) {
+  case UPDATE:
+    return "update";
+  case DRAW:
+    return "draw";
+  case PRESENT:
+    return "present";
+  case FRAME:
+    return "frame";
+  default:
+    return "?";
+  }
+}
+
+const char *Name(Scene scene) {
+  switch (scene) {
+  case Scene::NONE:
+    return "none";
+  case Scene::INTRO:
+    return "intro";
+  case Scene::GAME:
+    return "game";
+  case Scene::NEXT_ROUND:
+    return "next_round";
+  default:
+    return "?";
+  }
+}
+
+void BeginFrame() {
+  s_frame_start = std::chrono::steady_clock::now();
+  s_mark = s_frame_start;
+  for (int phase = 0; phase < PHASE_COUNT; phase++) {
+    s_phase_us[phase] = 0;
+    s_marked[phase] = false;
+  }
+}
+
+void Mark(Phase phase) {
+  const auto now = std::chrono::steady_clock::now();
+  s_phase_us[phase] += ElapsedUs(s_mark, now);
+  s_marked[phase] = true;
+  s_mark = now;
+}
+
+void EndFrame(Scene scene) {
+  s_phase_us[FRAME] = ElapsedUs(s_frame_start, std::chrono::steady_clock::now());
+  s_marked[FRAME] = true;
+
+  Histogram *histograms = s_histograms[static_cast<size_t>(scene)];
+  for (int phase = 0; phase < PHASE_COUNT; phase++) {
+    if (s_marked[phase]) {
+      Record(histograms[phase], s_phase_us[phase]);
+    }
+  }
+}
+
+Summary Summarize(Scene scene, Phase phase) {
+  const Histogram &histogram = s_histograms[static_cast<size_t>(scene)][phase];
+  if (histogram.frames == 0) {
+    return {0, 0., 0., 0., 0., 0.};
+  }
+  return {histogram.frames,
+          histogram.sum_us / 1e3 / histogram.frames,
+          Percentile(histogram, .50),
+          Percentile(histogram, .95),
+          Percentile(histogram, .99),
+          histogram.max_us / 1e3};
+}
+
+void Reset() {
+  for (auto &scene : s_histograms) {
+    for (auto &histogram : scene) {
+      histogram = {};
+    }
+  }
+}
+
+bool WriteCsv(const char *path) {
+  FILE *file = std::fopen(path, "w");
+  if (!file) {
+    return false;
+  }
+
+  std::fprintf(file, "scene,phase,frames,mean_ms,p50_ms,p95_ms,p99_ms,max_ms\n");
+  for (size_t s = 0; s < SCENE_COUNT; s++) {
+    const Scene scene = static_cast<Scene>(s);
+    for (int p = 0; p < PHASE_COUNT; p++) {
+      const Phase phase = static_cast<Phase>(p);
+      const Summary summary = Summarize(scene, phase);
+      if (summary.frames == 0) {
+        continue;
+      }
+      std::fprintf(file, "%s,%s,%llu,%.3f,%.3f,%.3f,%.3f,%.3f\n", Name(scene), Name(phase),
+                   static_cast<unsigned long long>(summary.frames), summary.mean_ms,
+                   summary.p50_ms, summary.p95_ms, summary.p99_ms, summary.max_ms);
+    }
+  }
+
+  return std::fclose(file) == 0;
+}
+
+} // namespace FrameStats
@@ -0,0 +1,50 @@
+#ifndef FRAME_STATS_H
+#define FRAME_STATS_H
+
+// Frame time distribution per scene and phase, for p50/p95/p99/max instead of an FPS counter.
+// Durations go into log-linear (HDR style) histograms: exact below 128 us, within 1/64 (1.6%)
+// above, up to about a minute. Recording never allocates.
+//
+//   FrameStats::BeginFrame();
+//   ...update...
+//   FrameStats::Mark(FrameStats::UPDATE);
+//   ...draw...
+//   FrameStats::Mark(FrameStats::DRAW);
+//   EndDrawing();
+//   FrameStats::Mark(FrameStats::PRESENT);
+//   FrameStats::EndFrame(g_currentScene);
+
+#include "scenes.hpp"
+#include <cstdint>
+
+namespace FrameStats {
+
+enum Phase { UPDATE, DRAW, PRESENT, FRAME, PHASE_COUNT }; // FRAME is the whole frame
+
+struct Summary {
+  uint64_t frames;
+  double mean_ms;
+  double p50_ms;
+  double p95_ms;
+  double p99_ms;
+  double max_ms;
+};
+
+const char *Name(Phase phase);
+const char *Name(Scene scene);
+
+void BeginFrame();
+// Time since the previous mark (or BeginFrame) goes to `phase`
+void Mark(Phase phase);
+// Records the frame under the scene it ended in, a load shows up in the scene it loaded
+void EndFrame(Scene scene);
+
+Summary Summarize(Scene scene, Phase phase);
+void Reset();
+
+// scene,phase,frames,mean_ms,p50_ms,p95_ms,p99_ms,max_ms for every scene that ran
+bool WriteCsv(const char *path);
+
+} // namespace FrameStats
+
+#endif
@@ -1,16 +1,11 @@
 #include "game.hpp"
-#include <random>
-
-// ENTROPY
-static std::random_device rd;
-static std::mt19937 gen(rd());
+#include "random.hpp"
 
 Game::Game g_Game;
 
 void Game::InitGame() {
-  std::uniform_int_distribution<int> num_of_s_meteors(g_Game.meteors.min_meteors,
-                                                      g_Game.meteors.max_meteors);
-  g_Game.meteors.count = num_of_s_meteors(gen);
+  g_Game.meteors.count =
+      Random::Get(Random::LEVEL).Int(g_Game.meteors.min_meteors, g_Game.meteors.max_meteors);
 }
 
 void Game::LoadLevel(int level) {
@@ -18,9 +13,8 @@ void Game::LoadLevel(int level) {
   g_Game.meteors.max_meteor_size = MAX_METEOR_SIZE + g_Game.level - 1;
   // TODO: change min_meteors too
 
-  std::uniform_int_distribution<int> num_of_s_meteors(g_Game.meteors.min_meteors,
-                                                      g_Game.meteors.max_meteors);
-  g_Game.meteors.count = num_of_s_meteors(gen);
+  g_Game.meteors.count =
+      Random::Get(Random::LEVEL).Int(g_Game.meteors.min_meteors, g_Game.meteors.max_meteors);
 
   // TODO: should be calculated per upgrade
   // g_Game.fuel_loss_rate = SPACESHIP_INITIAL_FUEL_LOSS_RATE;
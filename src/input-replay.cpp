@@ -0,0 +1,143 @@
+#include "input-replay.hpp"
+#include <cstring>
+
+namespace Platform {
+
+// FILE FORMAT: header, then one InputFrame per frame, native byte order
+struct ReplayHeader {
+  char magic[4];
+  uint32_t version;
+  uint64_t seed;
+};
+
+static constexpr char REPLAY_MAGIC[4] = {'M', 'N', 'R', 'P'};
+static constexpr uint32_t REPLAY_VERSION = 2; // 2: F2 recorded
+static constexpr int KEY_COUNT = sizeof(INPUT_KEYS) / sizeof(INPUT_KEYS[0]);
+static constexpr uint16_t MOUSE_LEFT_BIT = 1 << KEY_COUNT;
+static_assert(KEY_COUNT + 1 <= 16, "InputFrame masks are 16 bits");
+static_assert(sizeof(InputFrame) == 8, "InputFrame is written as is");
+
+// -1 for keys that are not recorded
+static int KeyBit(int key) {
+  for (int i = 0; i < KEY_COUNT; i++) {
+    if (INPUT_KEYS[i] == key) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// RECORDING
+
+RecordingBackend::RecordingBackend(std::unique_ptr<Backend> inner, const char *path,
+                                   uint64_t seed)
+    : ForwardingBackend(std::move(inner)), m_file(std::fopen(path, "wb")) {
+  if (m_file) {
+    ReplayHeader header{{}, REPLAY_VERSION, seed};
+    std::memcpy(header.magic, REPLAY_MAGIC, sizeof(header.magic));
+    std::fwrite(&header, sizeof(header), 1, m_file);
+  }
+}
+
+RecordingBackend::~RecordingBackend() {
+  if (m_file) {
+    std::fclose(m_file);
+  }
+}
+
+const InputFrame &RecordingBackend::Frame() {
+  if (!m_sampled) {
+    m_frame = {m_inner->GetFrameTime(), 0, 0};
+    for (int i = 0; i < KEY_COUNT; i++) {
+      m_frame.down |= m_inner->IsKeyDown(INPUT_KEYS[i]) << i;
+      m_frame.pressed |= m_inner->IsKeyPressed(INPUT_KEYS[i]) << i;
+    }
+    if (m_inner->IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+      m_frame.pressed |= MOUSE_LEFT_BIT;
+    }
+    m_sampled = true;
+  }
+  return m_frame;
+}
+
+float RecordingBackend::GetFrameTime() { return Frame().frame_time; }
+
+bool RecordingBackend::IsKeyDown(int key) {
+  const int bit = KeyBit(key);
+  return bit < 0 ? m_inner->IsKeyDown(key) : Frame().down >> bit & 1;
+}
+
+bool RecordingBackend::IsKeyPressed(int key) {
+  const int bit = KeyBit(key);
+  return bit < 0 ? m_inner->IsKeyPressed(key) : Frame().pressed >> bit & 1;
+}
+
+bool RecordingBackend::IsMouseButtonPressed(int button) {
+  if (button != MOUSE_LEFT_BUTTON) {
+    return m_inner->IsMouseButtonPressed(button);
+  }
+  return Frame().pressed & MOUSE_LEFT_BIT;
+}
+
+void RecordingBackend::EndDrawing() {
+  if (m_file) {
+    std::fwrite(&Frame(), sizeof(InputFrame), 1, m_file);
+  }
+  m_sampled = false;
+  m_inner->EndDrawing(); // polls the input of the next frame
+}
+
+// REPLAY
+
+ReplayBackend::ReplayBackend(std::unique_ptr<Backend> inner, const char *path)
+    : ForwardingBackend(std::move(inner)) {
+  FILE *file = std::fopen(path, "rb");
+  if (!file) {
+    return;
+  }
+
+  ReplayHeader header;
+  if (std::fread(&header, sizeof(header), 1, file) == 1 &&
+      std::memcmp(header.magic, REPLAY_MAGIC, sizeof(header.magic)) == 0 &&
+      header.version == REPLAY_VERSION) {
+    m_open = true;
+    m_seed = header.seed;
+    InputFrame frame;
+    while (std::fread(&frame, sizeof(frame), 1, file) == 1) {
+      m_frames.push_back(frame);
+    }
+  }
+  std::fclose(file);
+}
+
+const InputFrame &ReplayBackend::Frame() const {
+  static const InputFrame s_idle{0.f, 0, 0};
+  return m_frame < m_frames.size() ? m_frames[m_frame] : s_idle;
+}
+
+bool ReplayBackend::WindowShouldClose() {
+  return m_frame >= m_frames.size() || m_inner->WindowShouldClose();
+}
+
+float ReplayBackend::GetFrameTime() { return Frame().frame_time; }
+
+bool ReplayBackend::IsKeyDown(int key) {
+  const int bit = KeyBit(key);
+  return bit >= 0 && Frame().down >> bit & 1;
+}
+
+bool ReplayBackend::IsKeyPressed(int key) {
+  const int bit = KeyBit(key);
+  return bit >= 0 && Frame().pressed >> bit & 1;
+}
+
+bool ReplayBackend::IsMouseButtonPressed(int button) {
+  return button == MOUSE_LEFT_BUTTON && Frame().pressed & MOUSE_LEFT_BIT;
+}
+
+void ReplayBackend::EndDrawing() {
+  ++m_frame;
+  m_inner->EndDrawing();
+}
+
+} // namespace Platform
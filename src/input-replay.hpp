@@ -0,0 +1,80 @@
+#ifndef INPUT_REPLAY_H
+#define INPUT_REPLAY_H
+
+// Records the input and frame time of every frame to a file and plays it back, so the same
+// session can be rerun for profiling and regression comparisons. The file also carries the
+// session seed (see random.hpp); replays need the same --hz and --time-scale.
+//
+//   minoids --record session.mnr
+//   minoids --headless --replay session.mnr --frame-stats replay.csv
+//
+// Only the keys in INPUT_KEYS and the left mouse button are recorded. Replays see any other key
+// as released.
+
+#include "platform.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+namespace Platform {
+
+// What the game can query between two EndDrawing calls
+struct InputFrame {
+  float frame_time;
+  uint16_t down; // bit i: INPUT_KEYS[i], last bit: left mouse button
+  uint16_t pressed;
+};
+
+static constexpr int INPUT_KEYS[] = {KEY_RIGHT,  KEY_LEFT, KEY_UP, KEY_DOWN, KEY_SPACE, KEY_ENTER,
+                                     KEY_ESCAPE, KEY_F2,   KEY_F3, KEY_F4};
+
+class RecordingBackend final : public ForwardingBackend {
+public:
+  RecordingBackend(std::unique_ptr<Backend> inner, const char *path, uint64_t seed);
+  ~RecordingBackend() override;
+
+  bool IsOpen() const { return m_file != nullptr; }
+
+  float GetFrameTime() override;
+  bool IsKeyDown(int key) override;
+  bool IsKeyPressed(int key) override;
+  bool IsMouseButtonPressed(int button) override;
+  void EndDrawing() override;
+
+private:
+  // First query of a frame reads the whole frame from the inner backend
+  const InputFrame &Frame();
+
+  FILE *m_file;
+  InputFrame m_frame{};
+  bool m_sampled = false;
+};
+
+class ReplayBackend final : public ForwardingBackend {
+public:
+  ReplayBackend(std::unique_ptr<Backend> inner, const char *path);
+
+  bool IsOpen() const { return m_open; }
+  uint64_t Seed() const { return m_seed; }
+  size_t Frames() const { return m_frames.size(); }
+
+  bool WindowShouldClose() override; // also once the recording ends
+  float GetFrameTime() override;
+  bool IsKeyDown(int key) override;
+  bool IsKeyPressed(int key) override;
+  bool IsMouseButtonPressed(int button) override;
+  void EndDrawing() override;
+
+private:
+  const InputFrame &Frame() const;
+
+  bool m_open = false;
+  uint64_t m_seed = 0;
+  std::vector<InputFrame> m_frames;
+  size_t m_frame = 0;
+};
+
+} // namespace Platform
+
+#endif
@@ -0,0 +1,259 @@
+#include "jobs.hpp"
+#include "profiler.hpp"
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Jobs {
+
+static constexpr size_t QUEUE_CAPACITY = 1024; // per thread, a job that does not fit runs inline
+static constexpr size_t DEFERRED_CAPACITY = 64; // jobs waiting at once, a job past it waits in Run
+
+struct Task {
+  Job job;
+  Counter *counter;
+};
+
+// Fixed ring: its owner pushes and pops the newest end, thieves take the oldest
+class Queue {
+public:
+  bool Push(const Task &task) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_tail - m_head == QUEUE_CAPACITY) {
+      return false;
+    }
+    m_tasks[m_tail++ % QUEUE_CAPACITY] = task;
+    return true;
+  }
+
+  bool PopNewest(Task &task) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_tail == m_head) {
+      return false;
+    }
+    task = m_tasks[--m_tail % QUEUE_CAPACITY];
+    return true;
+  }
+
+  bool PopOldest(Task &task) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_tail == m_head) {
+      return false;
+    }
+    task = m_tasks[m_head++ % QUEUE_CAPACITY];
+    return true;
+  }
+
+private:
+  std::mutex m_mutex;
+  Task m_tasks[QUEUE_CAPACITY];
+  size_t m_head = 0;
+  size_t m_tail = 0;
+};
+
+// A job waiting for its `after` counter
+struct Deferred {
+  Task task;
+  const Counter *after;
+  Affinity affinity;
+};
+
+// queues[0] belongs to the main thread and any thread that is not a worker
+static std::vector<std::unique_ptr<Queue>> s_queues;
+static Queue s_mainThreadQueue; // MAIN_THREAD jobs, never stolen
+static std::vector<std::thread> s_workers;
+static std::thread::id s_mainThread;
+
+static std::mutex s_deferredMutex;
+static Deferred s_deferred[DEFERRED_CAPACITY];
+static size_t s_deferredCount = 0;
+
+// Workers sleep while nothing is queued
+static std::mutex s_sleepMutex;
+static std::condition_variable s_wake;
+static std::atomic<int> s_queued{0};
+static bool s_quit = false;
+
+static thread_local size_t t_queue = 0;
+
+class Scheduler {
+public:
+  static void Add(Counter &counter) { counter.m_count.fetch_add(1, std::memory_order_relaxed); }
+
+  static void Execute(Task &task) {
+    task.job();
+    if (task.counter) {
+      Finish(*task.counter);
+    }
+  }
+
+  static void Push(const Task &task, Affinity affinity) {
+    if (MAIN_THREAD == affinity) {
+      while (!s_mainThreadQueue.Push(task)) {
+        if (IsMainThread()) {
+          Task inline_task = task;
+          Execute(inline_task);
+          return;
+        }
+        std::this_thread::yield(); // until the main thread catches up
+      }
+      return;
+    }
+    if (s_workers.empty() || !s_queues[t_queue]->Push(task)) {
+      Task inline_task = task;
+      Execute(inline_task);
+      return;
+    }
+    s_queued.fetch_add(1, std::memory_order_release);
+    { std::lock_guard<std::mutex> lock(s_sleepMutex); }
+    s_wake.notify_one();
+  }
+
+private:
+  // Decrements `counter`. The last decrement takes the jobs waiting for it under the same lock:
+  // once the count is zero, Wait returns and a new counter may get the same address.
+  static void Finish(Counter &counter) {
+    int count = counter.m_count.load(std::memory_order_relaxed);
+    while (count > 1) {
+      if (counter.m_count.compare_exchange_weak(count, count - 1, std::memory_order_acq_rel,
+                                                std::memory_order_relaxed)) {
+        return;
+      }
+    }
+
+    Deferred ready[DEFERRED_CAPACITY];
+    size_t ready_count = 0;
+    {
+      std::lock_guard<std::mutex> lock(s_deferredMutex);
+      if (counter.m_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        size_t kept = 0;
+        for (size_t i = 0; i < s_deferredCount; i++) {
+          if (s_deferred[i].after == &counter) {
+            ready[ready_count++] = s_deferred[i];
+          } else {
+            s_deferred[kept++] = s_deferred[i];
+          }
+        }
+        s_deferredCount = kept;
+      }
+    }
+    for (size_t i = 0; i < ready_count; i++) {
+      Push(ready[i].task, ready[i].affinity);
+    }
+  }
+};
+
+// Own queue newest first, then the oldest job of the others
+static bool TryRunOne() {
+  Task task;
+  if (IsMainThread() && s_mainThreadQueue.PopOldest(task)) {
+    Scheduler::Execute(task);
+    return true;
+  }
+  if (s_queues.empty()) {
+    return false;
+  }
+
+  bool found = s_queues[t_queue]->PopNewest(task);
+  for (size_t i = 1; !found && i < s_queues.size(); i++) {
+    found = s_queues[(t_queue + i) % s_queues.size()]->PopOldest(task);
+  }
+  if (!found) {
+    return false;
+  }
+  s_queued.fetch_sub(1, std::memory_order_relaxed);
+  Scheduler::Execute(task);
+  return true;
+}
+
+static void Work(size_t queue) {
+  t_queue = queue;
+  while (true) {
+    if (TryRunOne()) {
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(s_sleepMutex);
+    s_wake.wait(lock, [] { return s_quit || s_queued.load(std::memory_order_acquire) > 0; });
+    if (s_quit && s_queued.load(std::memory_order_acquire) == 0) {
+      return;
+    }
+  }
+}
+
+void Init(int workers) {
+#if defined(PLATFORM_WEB)
+  workers = 0; // built without pthreads
+#endif
+  if (workers < 0) {
+    workers = std::max(0, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+  }
+
+  s_mainThread = std::this_thread::get_id();
+  t_queue = 0;
+  s_quit = false;
+  s_queues.clear();
+  for (int i = 0; i <= workers; i++) {
+    s_queues.push_back(std::make_unique<Queue>());
+  }
+  for (int i = 1; i <= workers; i++) {
+    s_workers.emplace_back(Work, static_cast<size_t>(i));
+  }
+}
+
+void Shutdown() {
+  {
+    std::lock_guard<std::mutex> lock(s_sleepMutex);
+    s_quit = true;
+  }
+  s_wake.notify_all();
+  for (auto &worker : s_workers) {
+    worker.join();
+  }
+  s_workers.clear();
+  RunMainThreadJobs();
+}
+
+int WorkerCount() { return static_cast<int>(s_workers.size()); }
+
+bool IsMainThread() { return std::this_thread::get_id() == s_mainThread; }
+
+void Run(Job job, Counter *counter, const Counter *after, Affinity affinity) {
+  if (counter) {
+    Scheduler::Add(*counter);
+  }
+  const Task task{job, counter};
+  if (after && !after->Done()) {
+    std::unique_lock<std::mutex> lock(s_deferredMutex);
+    // Checked again under the lock, the last decrement of `after` happens under it too
+    if (!after->Done() && s_deferredCount < DEFERRED_CAPACITY) {
+      s_deferred[s_deferredCount++] = {task, after, affinity};
+      return;
+    }
+    lock.unlock();
+    Wait(*after); // full: no room to defer, like a full queue runs its job inline
+  }
+  Scheduler::Push(task, affinity);
+}
+
+void Wait(const Counter &counter) {
+  if (counter.Done()) {
+    return;
+  }
+  PROFILE_SCOPE("Jobs::Wait");
+  while (!counter.Done()) {
+    if (!TryRunOne()) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+void RunMainThreadJobs() {
+  Task task;
+  while (s_mainThreadQueue.PopOldest(task)) {
+    Scheduler::Execute(task);
+  }
+}
+
+} // namespace Jobs
@@ -0,0 +1,112 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+// Work-stealing job system. Every worker owns a queue, runs its newest job first and steals the
+// oldest job of another queue when its own runs dry. Jobs are small closures stored inline, so
+// queueing one does not allocate.
+//
+//   Jobs::Counter decoded;
+//   Jobs::Run([&] { Decode(asset); }, &decoded);
+//   Jobs::Run([&] { Upload(asset); }, nullptr, &decoded, Jobs::MAIN_THREAD); // raylib
+//   Jobs::ParallelFor(count, 256, [&](size_t begin, size_t end) { ... });
+//   Jobs::Wait(decoded); // runs other jobs meanwhile
+//
+// raylib is only called from the main thread: MAIN_THREAD jobs run there, in RunMainThreadJobs
+// (once per frame) or while the main thread waits.
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace Jobs {
+
+// A closure of up to STORAGE bytes, trivially copyable: references, pointers and values
+class Job {
+public:
+  static constexpr size_t STORAGE = 48;
+
+  Job() = default;
+
+  template <typename F, typename Closure = std::decay_t<F>,
+            typename = std::enable_if_t<!std::is_same_v<Closure, Job>>>
+  Job(F &&function) {
+    static_assert(sizeof(Closure) <= STORAGE, "capture less, or capture a pointer to it");
+    static_assert(alignof(Closure) <= alignof(std::max_align_t));
+    static_assert(std::is_trivially_copyable_v<Closure> &&
+                      std::is_trivially_destructible_v<Closure>,
+                  "jobs are copied as bytes, capture references or plain values");
+    new (m_storage) Closure(std::forward<F>(function));
+    m_invoke = [](void *closure) { (*static_cast<Closure *>(closure))(); };
+  }
+
+  void operator()() { m_invoke(m_storage); }
+
+private:
+  alignas(std::max_align_t) unsigned char m_storage[STORAGE];
+  void (*m_invoke)(void *) = nullptr;
+};
+
+// Jobs in flight: Run adds one, each finished job removes one. Must outlive its jobs.
+class Counter {
+public:
+  Counter() = default;
+  Counter(const Counter &) = delete;
+  Counter &operator=(const Counter &) = delete;
+
+  bool Done() const { return m_count.load(std::memory_order_acquire) == 0; }
+
+private:
+  friend class Scheduler; // jobs.cpp
+  std::atomic<int> m_count{0};
+};
+
+enum Affinity { ANY, MAIN_THREAD };
+
+// workers < 0: one per core besides the main thread. 0 runs jobs on the thread that queues them.
+// The calling thread becomes the main thread.
+void Init(int workers = -1);
+// Joins the workers, every counter must be done
+void Shutdown();
+
+int WorkerCount();
+bool IsMainThread();
+
+// Queues `job`, which runs once `after` is done (when given) and then decrements `counter`.
+// With too many jobs already waiting on counters, Run waits for `after` itself.
+void Run(Job job, Counter *counter = nullptr, const Counter *after = nullptr,
+         Affinity affinity = ANY);
+
+// Runs queued jobs until `counter` is done, MAIN_THREAD ones too on the main thread
+void Wait(const Counter &counter);
+
+// MAIN_THREAD jobs queued so far, call once per frame
+void RunMainThreadJobs();
+
+// body(begin, end) over [0, count) in ranges of `grain` indices, returns once all ran. Ranges
+// are fixed by count and grain alone, whatever the number of workers.
+template <typename F> void ParallelFor(size_t count, size_t grain, F &&body) {
+  grain = std::max<size_t>(grain, 1);
+  if (count <= grain || WorkerCount() == 0) {
+    for (size_t begin = 0; begin < count; begin += grain) {
+      body(begin, std::min(count, begin + grain));
+    }
+    return;
+  }
+
+  Counter counter;
+  auto *function = &body;
+  // The caller takes the first range itself
+  for (size_t begin = grain; begin < count; begin += grain) {
+    const size_t end = std::min(count, begin + grain);
+    Run([function, begin, end] { (*function)(begin, end); }, &counter);
+  }
+  body(0, grain);
+  Wait(counter);
+}
+
+} // namespace Jobs
+
+#endif
@@ -0,0 +1,44 @@
+#include "meteor-shapes.hpp"
+#include "FastNoiseLite.h"
+#include "collision.hpp"
+#include <cmath>
+
+namespace MeteorShapes {
+
+static constexpr float NOISE_SCALE = .1f;
+// Samples lie on a circle, 1 noise unit apart, so the outline closes without a seam
+static constexpr float SAMPLE_RADIUS = POINT_COUNT / (2.f * PI);
+
+static float s_offsets[PROFILE_COUNT][POINT_COUNT];
+
+void Generate(int seed) {
+  // Every profile samples the same points, only the seed differs
+  static float s_xs[POINT_COUNT];
+  static float s_ys[POINT_COUNT];
+  static const bool s_sampled = [] {
+    for (int i = 0; i < POINT_COUNT; i++) {
+      const float angle = 2.f * PI * i / POINT_COUNT;
+      s_xs[i] = SAMPLE_RADIUS * std::cos(angle);
+      s_ys[i] = SAMPLE_RADIUS * std::sin(angle);
+    }
+    return true;
+  }();
+  (void)s_sampled;
+
+  FastNoiseLite noise;
+  noise.SetNoiseType(FastNoiseLite::NoiseType_Perlin);
+  noise.SetFrequency(NOISE_SCALE);
+
+  for (int profile = 0; profile < PROFILE_COUNT; profile++) {
+    noise.SetSeed(seed + profile);
+    noise.GetNoiseBatch(s_xs, s_ys, s_offsets[profile], POINT_COUNT);
+  }
+}
+
+const float *Offsets(Handle profile) { return s_offsets[profile % PROFILE_COUNT]; }
+
+float Radius(Handle profile, float base_radius, float amplitude, float angle) {
+  return base_radius + amplitude * ECS::ProfileRadius(Offsets(profile), POINT_COUNT, 0.f, angle);
+}
+
+} // namespace MeteorShapes
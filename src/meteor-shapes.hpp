@@ -0,0 +1,32 @@
+#ifndef METEOR_SHAPES_H
+#define METEOR_SHAPES_H
+
+// Outline profiles shared by every meteor. A RenderComponent only keeps the handle of one, so
+// creating a meteor neither allocates nor touches the noise generator, and any number of
+// meteors share PROFILE_COUNT * POINT_COUNT floats.
+
+#include "random.hpp"
+#include <cstdint>
+
+namespace MeteorShapes {
+
+constexpr int PROFILE_COUNT = 32;
+constexpr int POINT_COUNT = 80; // evenly spaced angles starting at 0
+
+using Handle = uint8_t;
+
+// Rebuilds every profile from `seed`, done per level. Meteors keep their handle and follow the
+// new outline, so call it before a level's meteors exist.
+void Generate(int seed);
+
+// POINT_COUNT offsets in [-1, 1], scaled by the meteor's noise amplitude
+const float *Offsets(Handle profile);
+
+// Outline radius at `angle` (radians), see ProfileRadius
+float Radius(Handle profile, float base_radius, float amplitude, float angle);
+
+inline Handle Pick(Random::Generator &rng) { return rng.Int(0, PROFILE_COUNT - 1); }
+
+} // namespace MeteorShapes
+
+#endif
@@ -1,9 +1,20 @@
 #include "FastNoiseLite.h"
+#include "alloc-tracker.hpp"
+#include "frame-stats.hpp"
 #include "game.hpp"
+#include "input-replay.hpp"
+#include "jobs.hpp"
+#include "platform.hpp"
+#include "profiler.hpp"
+#include "random.hpp"
 #include "raylib.h"
 #include "scenes.hpp"
+#include <algorithm>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <memory>
 #include <ostream>
 #include "resource_dir.h"
 
@@ -14,12 +25,52 @@
 static constexpr int SCREEN_WIDTH = 800;
 static constexpr int SCREEN_HEIGHT = 450;
 
+// SIMULATION
+static constexpr float DEFAULT_SIMULATION_HZ = 60.f;
+static constexpr float MAX_FRAME_TIME = .25f; // drop time instead of spiralling under load
+static float s_fixedStep = 1.f / DEFAULT_SIMULATION_HZ;
+static float s_timeScale = 1.f; // > 1 runs the simulation faster than real time
+static float s_accumulator = 0.f;
+
+// HEADLESS
+static bool s_headless = false; // no window or GPU, see Platform::NullBackend
+static size_t s_headlessFrames = 0; // 0 runs until the game exits
+static const Platform::NullBackend *s_nullBackend = nullptr;
+
+// RECORD / REPLAY
+static const char *s_recordPath = nullptr;
+static const char *s_replayPath = nullptr;
+static bool s_hasSeed = false; // --seed, otherwise Random's own startup seed
+static uint64_t s_seed = 0;
+
+// PROFILER (built with MINOIDS_PROFILE)
+static bool s_ProfilerOverlay = false; // toggled with F3
+static const char *s_tracePath = nullptr;
+
+// FRAME STATS
+static const char *s_frameStatsPath = nullptr; // written on exit when set, F4 writes any time
+static constexpr const char *DEFAULT_FRAME_STATS_PATH = "frame-stats.csv";
+
+// ALLOCATIONS (built with MINOIDS_TRACK_ALLOCS)
+static constexpr size_t STEADY_AFTER_FRAMES = 120; // scene warm-up, containers still grow
+static bool s_strictAllocs = false;
+static size_t s_sceneFrames = 0; // since the current scene was loaded
+
+// JOBS
+static int s_workers = -1; // one per core besides the main thread, 0 runs every job inline
+
+// PIPELINE: a frame's simulation runs as a job while the main thread draws what the previous
+// one built, so a frame takes the longer of the two instead of both
+static Jobs::Counter s_simulation;
+
 static void UpdateDrawFrame();
 static void HandleSceneEvent();
 static void LoadScene(Scene scene);
 static void UpdateCurrentScene(float delta);
 static void DrawCurrentScene();
 static void UnloadCurrentScene();
+static void SimulateCurrentScene(float delta);
+static void ParseArgs(int argc, char **argv);
 
 Scene g_currentScene = Scene::NONE;
 static bool s_AppShouldExit = false;
@@ -34,39 +85,121 @@ float PerlinNoise1D(float x);
 
 FastNoiseLite noise;
 
-int main(void) {
-  InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "MINOIDS");
-  SetExitKey(KEY_NULL); // disable Esc key
+extern Game::Game g_Game;
+
+int main(int argc, char **argv) {
+  ParseArgs(argc, argv);
+  AllocTracker::SetStrict(s_strictAllocs);
+  if (s_headless && s_recordPath) {
+    std::cerr << "--record needs a window, there is no input to record headless\n";
+    return 1;
+  }
+
+  std::unique_ptr<Platform::Backend> backend;
+  if (s_headless) {
+    auto null = std::make_unique<Platform::NullBackend>(s_fixedStep, s_headlessFrames);
+    s_nullBackend = null.get();
+    backend = std::move(null);
+  } else {
+    backend = std::make_unique<Platform::RaylibBackend>();
+  }
+
+  if (!s_hasSeed) {
+    s_seed = Random::MasterSeed();
+  }
+  if (s_replayPath) {
+    auto replay = std::make_unique<Platform::ReplayBackend>(std::move(backend), s_replayPath);
+    if (!replay->IsOpen()) {
+      std::cerr << "Could not read replay " << s_replayPath << "\n";
+      return 1;
+    }
+    s_seed = replay->Seed();
+    backend = std::move(replay);
+  } else if (s_recordPath) {
+    auto recording =
+        std::make_unique<Platform::RecordingBackend>(std::move(backend), s_recordPath, s_seed);
+    if (!recording->IsOpen()) {
+      std::cerr << "Could not write recording " << s_recordPath << "\n";
+      return 1;
+    }
+    backend = std::move(recording);
+  }
+  Platform::Set(std::move(backend));
+  Random::Seed(s_seed);
+  Jobs::Init(s_workers);
+
+  auto &platform = Platform::Get();
+  platform.InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "MINOIDS");
+  platform.SetExitKey(KEY_NULL); // disable Esc key
   SearchAndSetResourceDir("resources");
-  InitAudioDevice();
+  platform.InitAudioDevice();
 
 #if defined(PLATFORM_WEB)
   emscripten_set_main_loop(UpdateDrawFrame, 60, 1);
 #else
-  SetTargetFPS(60);
+  platform.SetTargetFPS(60);
 
   // noise.SetNoiseType(FastNoiseLite::NoiseType_Perlin);
   // noise.SetFrequency(NOISE_SCALE);
 
   Game::InitGame();
-  LoadScene(Scene::INTRO);
+  // Nobody is there to press a key on the intro, unless a replay is
+  LoadScene(s_headless && !s_replayPath ? Scene::GAME : Scene::INTRO);
 
   // Main game loop
-  while (!WindowShouldClose() && !s_AppShouldExit) {
+  while (!platform.WindowShouldClose() && !s_AppShouldExit) {
     UpdateDrawFrame();
   }
 #endif
 
   UnloadCurrentScene();
-  CloseAudioDevice();
-  CloseWindow();
+  Jobs::Shutdown();
+  platform.CloseAudioDevice();
+  platform.CloseWindow();
+
+  if (s_frameStatsPath && !FrameStats::WriteCsv(s_frameStatsPath)) {
+    std::cerr << "Could not write frame stats to " << s_frameStatsPath << "\n";
+  }
+
+  if (s_tracePath && !Profiler::WriteChromeTrace(s_tracePath)) {
+    std::cerr << "Could not write trace to " << s_tracePath << "\n";
+  }
+
+  if (s_nullBackend) {
+    const auto &null = *s_nullBackend;
+    std::cout << "frames: " << null.Frames() << ", draw calls: " << null.DrawCalls()
+              << ", last frame: " << null.LastFrameDrawCalls() << "\n";
+    // Same seed and input, same numbers: compare them across replays
+    std::cout << "seed: " << s_seed << ", level: " << g_Game.level << ", score: " << g_Game.score
+              << ", cores: " << g_Game.total_cores << ", lives: " << g_Game.lives << "\n";
+    const auto game = FrameStats::Summarize(Scene::GAME, FrameStats::FRAME);
+    std::cout << "game frame ms: p50 " << game.p50_ms << ", p95 " << game.p95_ms << ", p99 "
+              << game.p99_ms << ", max " << game.max_ms << "\n";
+  }
+
+  if (AllocTracker::Violations() > 0) {
+    std::cerr << AllocTracker::Violations() << " steady frames allocated\n";
+    return 1;
+  }
 
   return 0;
 }
 
 // Update and draw game frame
 static void UpdateDrawFrame(void) {
-  float delta = GetFrameTime();
+  FrameStats::BeginFrame();
+  auto &platform = Platform::Get();
+  float delta = platform.GetFrameTime();
+
+  if (platform.IsKeyPressed(KEY_F3)) {
+    s_ProfilerOverlay = !s_ProfilerOverlay;
+  }
+  if (platform.IsKeyPressed(KEY_F4)) {
+    const char *path = s_frameStatsPath ? s_frameStatsPath : DEFAULT_FRAME_STATS_PATH;
+    if (FrameStats::WriteCsv(path)) {
+      std::cout << "Frame stats written to " << path << "\n";
+    }
+  }
 
   // SCENE EVENT PHASE
   HandleSceneEvent();
@@ -74,6 +207,10 @@ static void UpdateDrawFrame(void) {
   // UPDATE PHASE
   UpdateCurrentScene(delta);
 
+  // SIMULATION PHASE (fixed step), runs during the draw phase
+  Jobs::Run([delta] { SimulateCurrentScene(delta); }, &s_simulation);
+  FrameStats::Mark(FrameStats::UPDATE);
+
   // Vector2 center = {SCREEN_WIDTH / 2.0f, SCREEN_HEIGHT / 2.0f};
   //
   // if (IsKeyDown(KEY_UP)) {
@@ -116,11 +253,17 @@ static void UpdateDrawFrame(void) {
   // Optional: Draw base circle for reference
   // DrawCircleLines((int)center.x, (int)center.y, RADIUS, LIGHTGRAY);
 
+  // Texture uploads and other raylib calls queued by jobs
+  Jobs::RunMainThreadJobs();
+
   // DRAW PHASE
-  BeginDrawing();
+  platform.BeginDrawing();
 
-  ClearBackground(RAYWHITE);
+  platform.ClearBackground(RAYWHITE);
   DrawCurrentScene();
+  if (s_ProfilerOverlay) {
+    Profiler::DrawOverlay(10, 170);
+  }
 
   // DEBUG PRINT ECS STATE
   // int posX = 10, posY = GetScreenHeight() - 20, i = 0;
@@ -136,13 +279,89 @@ static void UpdateDrawFrame(void) {
   // }
   // DrawFPS(GetScreenWidth() - 80, GetScreenHeight() - 30);
 
-  EndDrawing();
+  // Done before EndDrawing polls the input of the next frame. DRAW includes this wait, i.e the
+  // part of the simulation the draw phase did not hide.
+  Jobs::Wait(s_simulation);
+  if (Scene::GAME == g_currentScene) {
+    SwapGameFrame();
+  }
+
+  FrameStats::Mark(FrameStats::DRAW);
+  platform.EndDrawing();
+  FrameStats::Mark(FrameStats::PRESENT);
+  FrameStats::EndFrame(g_currentScene);
+
+  Profiler::EndFrame();
+
+  // Gameplay frames past the warm-up should not touch the heap
+  s_sceneFrames++;
+  const bool steady =
+      Scene::GAME == g_currentScene && !s_OverlayMenu && s_sceneFrames > STEADY_AFTER_FRAMES;
+  AllocTracker::EndFrame(steady);
 }
 
 // Basic pseudo Perlin noise function using sine
 float PerlinNoise1D(float x) { return 0.5f * (sinf(x) + sinf(x * 0.5f + 3.14f)); }
 
+// --hz <ticks per second> --time-scale <factor> --headless [--frames <count>]
+// --trace <chrome trace json written on exit> --frame-stats <csv written on exit>
+// --strict-allocs --seed <n> --record <file> --replay <file> --workers <count>
+static void ParseArgs(int argc, char **argv) {
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--headless") == 0) {
+      s_headless = true;
+    } else if (strcmp(argv[i], "--strict-allocs") == 0) {
+      s_strictAllocs = true;
+    } else if (i + 1 == argc) {
+      break;
+    } else if (strcmp(argv[i], "--trace") == 0) {
+      s_tracePath = argv[++i];
+    } else if (strcmp(argv[i], "--seed") == 0) {
+      s_seed = strtoull(argv[++i], nullptr, 10);
+      s_hasSeed = true;
+    } else if (strcmp(argv[i], "--record") == 0) {
+      s_recordPath = argv[++i];
+    } else if (strcmp(argv[i], "--replay") == 0) {
+      s_replayPath = argv[++i];
+    } else if (strcmp(argv[i], "--frame-stats") == 0) {
+      s_frameStatsPath = argv[++i];
+    } else if (strcmp(argv[i], "--workers") == 0) {
+      s_workers = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--frames") == 0) {
+      s_headlessFrames = strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "--hz") == 0) {
+      const float hz = strtof(argv[++i], nullptr);
+      if (hz > 0.f) {
+        s_fixedStep = 1.f / hz;
+      }
+    } else if (strcmp(argv[i], "--time-scale") == 0) {
+      const float scale = strtof(argv[++i], nullptr);
+      if (scale > 0.f) {
+        s_timeScale = scale;
+      }
+    }
+  }
+}
+
+// Advances the simulation in fixed steps and builds the next frame with the remainder for render
+// interpolation. A job: only the draw phase runs meanwhile, it draws the previous frame.
+static void SimulateCurrentScene(float delta) {
+  PROFILE_SCOPE("SimulateCurrentScene");
+  if (Scene::GAME != g_currentScene) {
+    return;
+  }
+
+  s_accumulator += std::min(delta, MAX_FRAME_TIME) * s_timeScale;
+  while (s_accumulator >= s_fixedStep) {
+    StepGame(s_fixedStep);
+    s_accumulator -= s_fixedStep;
+  }
+
+  BuildGameFrame(s_accumulator / s_fixedStep);
+}
+
 static void UnloadCurrentScene() {
+  PROFILE_SCOPE("UnloadScene");
   switch (g_currentScene) {
   case Scene::INTRO:
     UnloadIntro();
@@ -160,10 +379,13 @@ static void UnloadCurrentScene() {
 }
 
 static void LoadScene(Scene scene) {
+  PROFILE_SCOPE("LoadScene");
   if (scene != g_currentScene) {
     UnloadCurrentScene();
 
     g_currentScene = scene;
+    s_accumulator = 0.f;
+    s_sceneFrames = 0;
 
     switch (scene) {
     case Scene::INTRO:
@@ -185,6 +407,7 @@ static void LoadScene(Scene scene) {
 }
 
 static void UpdateCurrentScene(float delta) {
+  PROFILE_SCOPE("UpdateCurrentScene");
   switch (g_currentScene) {
   case Scene::INTRO:
     UpdateIntro(delta);
@@ -205,6 +428,7 @@ static void UpdateCurrentScene(float delta) {
 }
 
 static void DrawCurrentScene() {
+  PROFILE_SCOPE("DrawCurrentScene");
   switch (g_currentScene) {
   case Scene::INTRO:
     DrawIntro();
@@ -225,6 +449,7 @@ static void DrawCurrentScene() {
 }
 
 static void HandleSceneEvent() {
+  PROFILE_SCOPE("HandleSceneEvent");
   // Handle Overlay in focus
   if (s_OverlayMenu) {
     SceneEvent event = OnMenuEvent();
@@ -0,0 +1,145 @@
+#include "perf-counters.hpp"
+#include <atomic>
+#include <cstdio>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace PerfCounters {
+
+const char *Name(Counter counter) {
+  switch (counter) {
+  case CYCLES:
+    return "cycles";
+  case INSTRUCTIONS:
+    return "instructions";
+  case L1D_MISSES:
+    return "l1d_misses";
+  case LLC_MISSES:
+    return "llc_misses";
+  case BRANCH_MISSES:
+    return "branch_misses";
+  default:
+    return "?";
+  }
+}
+
+#if defined(__linux__)
+
+// One group per thread, read with a single syscall
+struct Group {
+  bool opened = false;
+  int leader = -1;
+  int members = 0;
+  int counter[COUNT]; // counter of each group member
+};
+
+static thread_local Group t_group;
+static std::atomic<bool> s_warned{false};
+
+static perf_event_attr Attr(Counter counter) {
+  perf_event_attr attr{};
+  attr.size = sizeof(attr);
+  attr.exclude_kernel = 1; // allowed with perf_event_paranoid <= 2
+  attr.exclude_hv = 1;
+  attr.read_format =
+      PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+  switch (counter) {
+  case CYCLES:
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CPU_CYCLES;
+    break;
+  case INSTRUCTIONS:
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    break;
+  case L1D_MISSES:
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_L1D | PERF_COUNT_HW_CACHE_OP_READ << 8 |
+                  PERF_COUNT_HW_CACHE_RESULT_MISS << 16;
+    break;
+  case LLC_MISSES:
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    break;
+  case BRANCH_MISSES:
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+    break;
+  default:
+    break;
+  }
+  return attr;
+}
+
+static void Open(Group &group) {
+  group.opened = true;
+
+  for (int c = 0; c < COUNT; c++) {
+    perf_event_attr attr = Attr(static_cast<Counter>(c));
+    const int fd = syscall(SYS_perf_event_open, &attr, 0 /* this thread */, -1 /* any cpu */,
+                           group.leader, 0);
+    if (fd < 0) {
+      if (c == CYCLES) {
+        // Without the leader there is no group at all
+        if (!s_warned.exchange(true)) {
+          std::fprintf(stderr,
+                       "Hardware counters unavailable (%s), check "
+                       "/proc/sys/kernel/perf_event_paranoid\n",
+                       std::strerror(errno));
+        }
+        return;
+      }
+      continue; // the CPU lacks this one, it reads as 0
+    }
+
+    if (group.leader < 0) {
+      group.leader = fd;
+    }
+    group.counter[group.members++] = c;
+  }
+
+  ioctl(group.leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(group.leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+bool Read(Sample &sample) {
+  Group &group = t_group;
+  if (!group.opened) {
+    Open(group);
+  }
+  if (group.leader < 0) {
+    return false;
+  }
+
+  // nr, time_enabled, time_running, values[nr]
+  uint64_t data[3 + COUNT];
+  if (read(group.leader, data, sizeof(data)) < static_cast<ssize_t>(3 * sizeof(uint64_t))) {
+    return false;
+  }
+
+  // More counters than the PMU has are multiplexed, scale them to the whole time
+  const double scale = data[2] > 0 ? static_cast<double>(data[1]) / data[2] : 1.;
+  for (int c = 0; c < COUNT; c++) {
+    sample.values[c] = 0;
+  }
+  for (uint64_t i = 0; i < data[0] && i < COUNT; i++) {
+    sample.values[group.counter[i]] = static_cast<uint64_t>(data[3 + i] * scale);
+  }
+  return true;
+}
+
+#else
+
+bool Read(Sample &sample) { return false; }
+
+#endif
+
+} // namespace PerfCounters
@@ -0,0 +1,25 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+// Hardware counters of the calling thread through Linux perf_event_open.
+// Used by the profiler when built with MINOIDS_PERF_COUNTERS. Elsewhere, or when the kernel
+// refuses (perf_event_paranoid, containers, VMs without a PMU), Read() returns false.
+
+#include <cstdint>
+
+namespace PerfCounters {
+
+enum Counter { CYCLES, INSTRUCTIONS, L1D_MISSES, LLC_MISSES, BRANCH_MISSES, COUNT };
+
+struct Sample {
+  uint64_t values[COUNT]; // 0 for counters the CPU does not have
+};
+
+const char *Name(Counter counter);
+
+// Opens the counters of the calling thread on first use
+bool Read(Sample &sample);
+
+} // namespace PerfCounters
+
+#endif
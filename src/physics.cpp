@@ -0,0 +1,111 @@
+#include "physics.hpp"
+#include <algorithm>
+
+namespace ECS {
+
+void ImpulseSolver::Reserve(size_t bodies, size_t contacts) {
+  m_vx.reserve(bodies);
+  m_vy.reserve(bodies);
+  m_inv_mass.reserve(bodies);
+  m_px.reserve(bodies);
+  m_py.reserve(bodies);
+
+  m_a.reserve(contacts);
+  m_b.reserve(contacts);
+  m_nx.reserve(contacts);
+  m_ny.reserve(contacts);
+  m_penetration.reserve(contacts);
+  m_mass.reserve(contacts);
+  m_bias.reserve(contacts);
+  m_acc.reserve(contacts);
+  m_lambda.reserve(contacts);
+}
+
+void ImpulseSolver::Clear() {
+  m_vx.clear();
+  m_vy.clear();
+  m_inv_mass.clear();
+  m_px.clear();
+  m_py.clear();
+
+  m_a.clear();
+  m_b.clear();
+  m_nx.clear();
+  m_ny.clear();
+  m_penetration.clear();
+  m_mass.clear();
+  m_bias.clear();
+  m_acc.clear();
+  m_lambda.clear();
+}
+
+uint32_t ImpulseSolver::AddBody(const Vector2 &velocity, float inv_mass) {
+  m_vx.push_back(velocity.x);
+  m_vy.push_back(velocity.y);
+  m_inv_mass.push_back(inv_mass);
+  m_px.push_back(0.f);
+  m_py.push_back(0.f);
+  return m_vx.size() - 1;
+}
+
+void ImpulseSolver::AddContact(uint32_t a, uint32_t b, const Vector2 &normal, float penetration,
+                               float restitution) {
+  const float inv_mass = m_inv_mass[a] + m_inv_mass[b];
+  if (inv_mass <= 0.f) {
+    return;
+  }
+
+  // Bounce off the approaching velocity only
+  const float vn = (m_vx[b] - m_vx[a]) * normal.x + (m_vy[b] - m_vy[a]) * normal.y;
+
+  m_a.push_back(a);
+  m_b.push_back(b);
+  m_nx.push_back(normal.x);
+  m_ny.push_back(normal.y);
+  m_penetration.push_back(penetration);
+  m_mass.push_back(1.f / inv_mass);
+  m_bias.push_back(vn < 0.f ? -restitution * vn : 0.f);
+  m_acc.push_back(0.f);
+  m_lambda.push_back(0.f);
+}
+
+void ImpulseSolver::Solve(int iterations) {
+  const size_t count = m_a.size();
+
+  for (int iteration = 0; iteration < iterations; iteration++) {
+    // Impulses, all from the same velocities
+    for (size_t c = 0; c < count; c++) {
+      const uint32_t a = m_a[c];
+      const uint32_t b = m_b[c];
+      const float vn = (m_vx[b] - m_vx[a]) * m_nx[c] + (m_vy[b] - m_vy[a]) * m_ny[c];
+      const float acc = std::max(m_acc[c] + (m_bias[c] - vn) * m_mass[c], 0.f);
+      m_lambda[c] = acc - m_acc[c];
+      m_acc[c] = acc;
+    }
+
+    // Apply
+    for (size_t c = 0; c < count; c++) {
+      const uint32_t a = m_a[c];
+      const uint32_t b = m_b[c];
+      const float jx = m_lambda[c] * m_nx[c];
+      const float jy = m_lambda[c] * m_ny[c];
+      m_vx[a] -= jx * m_inv_mass[a];
+      m_vy[a] -= jy * m_inv_mass[a];
+      m_vx[b] += jx * m_inv_mass[b];
+      m_vy[b] += jy * m_inv_mass[b];
+    }
+  }
+
+  // Separate penetrating bodies, split by inverse mass
+  for (size_t c = 0; c < count; c++) {
+    const uint32_t a = m_a[c];
+    const uint32_t b = m_b[c];
+    const float push = std::max(m_penetration[c] - SLOP, 0.f) * PUSH_OUT * m_mass[c];
+    m_px[a] -= push * m_nx[c] * m_inv_mass[a];
+    m_py[a] -= push * m_ny[c] * m_inv_mass[a];
+    m_px[b] += push * m_nx[c] * m_inv_mass[b];
+    m_py[b] += push * m_ny[c] * m_inv_mass[b];
+  }
+}
+
+} // namespace ECS
@@ -0,0 +1,65 @@
+#ifndef PHYSICS_H
+#define PHYSICS_H
+
+#include "raylib.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ECS {
+
+constexpr int SOLVER_ITERATIONS = 4;
+constexpr float SLEEP_SPEED = .02f; // per frame
+constexpr int SLEEP_FRAMES = 60;    // in a contact and below SLEEP_SPEED before falling asleep
+constexpr float WAKE_SPEED = .05f;  // velocity change that wakes a sleeping body
+
+// Touching pair of bodies found by the collision detection
+struct BodyContact {
+  size_t a; // entity
+  size_t b;
+  Vector2 normal; // from a to b
+  float penetration;
+};
+
+// Impulse solver for circle bodies.
+// Bodies and contacts are kept in SoA arrays. Every iteration computes all contact impulses
+// from the same velocities (Jacobi) and then applies them, so the inner loop has no
+// dependencies between contacts.
+class ImpulseSolver {
+public:
+  static constexpr float SLOP = .5f;     // penetration allowed before pushing apart
+  static constexpr float PUSH_OUT = .8f; // fraction of the penetration fixed per frame
+
+  // Room for `bodies` and `contacts`, so steady frames below them do not allocate
+  void Reserve(size_t bodies, size_t contacts);
+  void Clear();
+
+  uint32_t AddBody(const Vector2 &velocity, float inv_mass);
+  // normal points from a to b
+  void AddContact(uint32_t a, uint32_t b, const Vector2 &normal, float penetration,
+                  float restitution);
+
+  void Solve(int iterations);
+
+  size_t BodyCount() const { return m_vx.size(); }
+  Vector2 Velocity(uint32_t body) const { return {m_vx[body], m_vy[body]}; }
+  // Position change that separates penetrating bodies
+  Vector2 Correction(uint32_t body) const { return {m_px[body], m_py[body]}; }
+
+private:
+  // BODIES
+  std::vector<float> m_vx, m_vy, m_inv_mass;
+  std::vector<float> m_px, m_py; // position corrections
+
+  // CONTACTS
+  std::vector<uint32_t> m_a, m_b;
+  std::vector<float> m_nx, m_ny, m_penetration;
+  std::vector<float> m_mass;     // 1 / (inv_mass_a + inv_mass_b)
+  std::vector<float> m_bias;     // target separating velocity from restitution
+  std::vector<float> m_acc;      // accumulated impulse, never negative
+  std::vector<float> m_lambda;   // impulse delta of the current iteration
+};
+
+} // namespace ECS
+
+#endif
@@ -0,0 +1,127 @@
+#include "platform.hpp"
+#include <cstdio>
+#include <cstring>
+
+namespace Platform {
+
+// RAYLIB
+
+void RaylibBackend::InitWindow(int width, int height, const char *title) {
+  ::InitWindow(width, height, title);
+}
+void RaylibBackend::CloseWindow() { ::CloseWindow(); }
+bool RaylibBackend::WindowShouldClose() { return ::WindowShouldClose(); }
+void RaylibBackend::SetTargetFPS(int fps) { ::SetTargetFPS(fps); }
+int RaylibBackend::GetScreenWidth() { return ::GetScreenWidth(); }
+int RaylibBackend::GetScreenHeight() { return ::GetScreenHeight(); }
+float RaylibBackend::GetFrameTime() { return ::GetFrameTime(); }
+void RaylibBackend::InitAudioDevice() { ::InitAudioDevice(); }
+void RaylibBackend::CloseAudioDevice() { ::CloseAudioDevice(); }
+
+void RaylibBackend::SetExitKey(int key) { ::SetExitKey(key); }
+bool RaylibBackend::IsKeyDown(int key) { return ::IsKeyDown(key); }
+bool RaylibBackend::IsKeyPressed(int key) { return ::IsKeyPressed(key); }
+bool RaylibBackend::IsMouseButtonPressed(int button) { return ::IsMouseButtonPressed(button); }
+
+void RaylibBackend::BeginDrawing() { ::BeginDrawing(); }
+void RaylibBackend::EndDrawing() { ::EndDrawing(); }
+void RaylibBackend::ClearBackground(Color color) { ::ClearBackground(color); }
+void RaylibBackend::BeginMode2D(Camera2D camera) { ::BeginMode2D(camera); }
+void RaylibBackend::EndMode2D() { ::EndMode2D(); }
+void RaylibBackend::DrawLine(int startX, int startY, int endX, int endY, Color color) {
+  ::DrawLine(startX, startY, endX, endY, color);
+}
+void RaylibBackend::DrawCircle(int centerX, int centerY, float radius, Color color) {
+  ::DrawCircle(centerX, centerY, radius, color);
+}
+void RaylibBackend::DrawEllipseLines(int centerX, int centerY, float radiusH, float radiusV,
+                                     Color color) {
+  ::DrawEllipseLines(centerX, centerY, radiusH, radiusV, color);
+}
+void RaylibBackend::DrawRectangle(int posX, int posY, int width, int height, Color color) {
+  ::DrawRectangle(posX, posY, width, height, color);
+}
+void RaylibBackend::DrawRectangleLines(int posX, int posY, int width, int height, Color color) {
+  ::DrawRectangleLines(posX, posY, width, height, color);
+}
+void RaylibBackend::DrawTriangle(Vector2 v1, Vector2 v2, Vector2 v3, Color color) {
+  ::DrawTriangle(v1, v2, v3, color);
+}
+void RaylibBackend::DrawTextureEx(Texture2D texture, Vector2 position, float rotation,
+                                  float scale, Color tint) {
+  ::DrawTextureEx(texture, position, rotation, scale, tint);
+}
+void RaylibBackend::DrawText(const char *text, int posX, int posY, int fontSize, Color color) {
+  ::DrawText(text, posX, posY, fontSize, color);
+}
+int RaylibBackend::MeasureText(const char *text, int fontSize) {
+  return ::MeasureText(text, fontSize);
+}
+
+Texture2D RaylibBackend::LoadTexture(const char *filename) { return ::LoadTexture(filename); }
+Texture2D RaylibBackend::LoadTextureFromImage(Image image) { return ::LoadTextureFromImage(image); }
+void RaylibBackend::UnloadTexture(Texture2D texture) { ::UnloadTexture(texture); }
+
+// NULL
+
+void NullBackend::InitWindow(int width, int height, const char *title) {
+  m_width = width;
+  m_height = height;
+}
+
+bool NullBackend::WindowShouldClose() { return m_max_frames > 0 && m_frames >= m_max_frames; }
+
+void NullBackend::EndDrawing() {
+  m_last_frame_draw_calls = m_frame_draw_calls;
+  ++m_frames;
+}
+
+// Close to raylib's default font, which is what layout code cares about
+int NullBackend::MeasureText(const char *text, int fontSize) {
+  return static_cast<int>(std::strlen(text)) * fontSize / 2;
+}
+
+// Only the size is read (PNG IHDR), the texture has no GPU id
+Texture2D NullBackend::LoadTexture(const char *filename) {
+  Texture2D texture{};
+  FILE *file = std::fopen(filename, "rb");
+  if (!file) {
+    return texture;
+  }
+
+  unsigned char header[24];
+  if (std::fread(header, 1, sizeof(header), file) == sizeof(header) &&
+      std::memcmp(header + 12, "IHDR", 4) == 0) {
+    texture.width = header[16] << 24 | header[17] << 16 | header[18] << 8 | header[19];
+    texture.height = header[20] << 24 | header[21] << 16 | header[22] << 8 | header[23];
+    texture.mipmaps = 1;
+    texture.format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+  }
+  std::fclose(file);
+  return texture;
+}
+
+// Same as LoadTexture, the size without a GPU id
+Texture2D NullBackend::LoadTextureFromImage(Image image) {
+  Texture2D texture{};
+  texture.width = image.width;
+  texture.height = image.height;
+  texture.mipmaps = image.mipmaps;
+  texture.format = image.format;
+  return texture;
+}
+
+// CURRENT
+
+static std::unique_ptr<Backend> s_backend;
+
+Backend &Get() {
+  if (!s_backend) {
+    s_backend = std::make_unique<RaylibBackend>();
+  }
+  return *s_backend;
+}
+
+void Set(std::unique_ptr<Backend> backend) { s_backend = std::move(backend); }
+
+} // namespace Platform
@@ -0,0 +1,245 @@
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+#include "raylib.h"
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace Platform {
+
+// Everything the game needs from the window, input and GPU.
+// Systems go through the current backend instead of calling raylib, so the same game loop can
+// run on a window (RaylibBackend) or headless (NullBackend).
+class Backend {
+public:
+  virtual ~Backend() = default;
+
+  // WINDOW
+  virtual void InitWindow(int width, int height, const char *title) = 0;
+  virtual void CloseWindow() = 0;
+  virtual bool WindowShouldClose() = 0;
+  virtual void SetTargetFPS(int fps) = 0;
+  virtual int GetScreenWidth() = 0;
+  virtual int GetScreenHeight() = 0;
+  virtual float GetFrameTime() = 0;
+  virtual void InitAudioDevice() = 0;
+  virtual void CloseAudioDevice() = 0;
+
+  // INPUT
+  virtual void SetExitKey(int key) = 0;
+  virtual bool IsKeyDown(int key) = 0;
+  virtual bool IsKeyPressed(int key) = 0;
+  virtual bool IsMouseButtonPressed(int button) = 0;
+
+  // DRAWING
+  virtual void BeginDrawing() = 0;
+  virtual void EndDrawing() = 0;
+  virtual void ClearBackground(Color color) = 0;
+  virtual void BeginMode2D(Camera2D camera) = 0; // draw calls until EndMode2D are in world space
+  virtual void EndMode2D() = 0;
+  virtual void DrawLine(int startX, int startY, int endX, int endY, Color color) = 0;
+  virtual void DrawCircle(int centerX, int centerY, float radius, Color color) = 0;
+  virtual void DrawEllipseLines(int centerX, int centerY, float radiusH, float radiusV,
+                                Color color) = 0;
+  virtual void DrawRectangle(int posX, int posY, int width, int height, Color color) = 0;
+  virtual void DrawRectangleLines(int posX, int posY, int width, int height, Color color) = 0;
+  virtual void DrawTriangle(Vector2 v1, Vector2 v2, Vector2 v3, Color color) = 0;
+  virtual void DrawTextureEx(Texture2D texture, Vector2 position, float rotation, float scale,
+                             Color tint) = 0;
+  virtual void DrawText(const char *text, int posX, int posY, int fontSize, Color color) = 0;
+  virtual int MeasureText(const char *text, int fontSize) = 0;
+
+  // TEXTURES
+  virtual Texture2D LoadTexture(const char *filename) = 0;
+  virtual Texture2D LoadTextureFromImage(Image image) = 0; // copies the pixels, image stays owned
+  virtual void UnloadTexture(Texture2D texture) = 0;
+};
+
+class RaylibBackend final : public Backend {
+public:
+  void InitWindow(int width, int height, const char *title) override;
+  void CloseWindow() override;
+  bool WindowShouldClose() override;
+  void SetTargetFPS(int fps) override;
+  int GetScreenWidth() override;
+  int GetScreenHeight() override;
+  float GetFrameTime() override;
+  void InitAudioDevice() override;
+  void CloseAudioDevice() override;
+
+  void SetExitKey(int key) override;
+  bool IsKeyDown(int key) override;
+  bool IsKeyPressed(int key) override;
+  bool IsMouseButtonPressed(int button) override;
+
+  void BeginDrawing() override;
+  void EndDrawing() override;
+  void ClearBackground(Color color) override;
+  void BeginMode2D(Camera2D camera) override;
+  void EndMode2D() override;
+  void DrawLine(int startX, int startY, int endX, int endY, Color color) override;
+  void DrawCircle(int centerX, int centerY, float radius, Color color) override;
+  void DrawEllipseLines(int centerX, int centerY, float radiusH, float radiusV,
+                        Color color) override;
+  void DrawRectangle(int posX, int posY, int width, int height, Color color) override;
+  void DrawRectangleLines(int posX, int posY, int width, int height, Color color) override;
+  void DrawTriangle(Vector2 v1, Vector2 v2, Vector2 v3, Color color) override;
+  void DrawTextureEx(Texture2D texture, Vector2 position, float rotation, float scale,
+                     Color tint) override;
+  void DrawText(const char *text, int posX, int posY, int fontSize, Color color) override;
+  int MeasureText(const char *text, int fontSize) override;
+
+  Texture2D LoadTexture(const char *filename) override;
+  Texture2D LoadTextureFromImage(Image image) override;
+  void UnloadTexture(Texture2D texture) override;
+};
+
+// No window, no GPU, no input. Draw calls are only counted and every frame lasts exactly
+// `frame_time`, so the loop runs as fast as the simulation allows.
+class NullBackend final : public Backend {
+public:
+  // max_frames == 0 runs until the game exits by itself
+  explicit NullBackend(float frame_time, size_t max_frames = 0)
+      : m_frame_time(frame_time), m_max_frames(max_frames) {}
+
+  void InitWindow(int width, int height, const char *title) override;
+  void CloseWindow() override {}
+  bool WindowShouldClose() override;
+  void SetTargetFPS(int fps) override {}
+  int GetScreenWidth() override { return m_width; }
+  int GetScreenHeight() override { return m_height; }
+  float GetFrameTime() override { return m_frame_time; }
+  void InitAudioDevice() override {}
+  void CloseAudioDevice() override {}
+
+  void SetExitKey(int key) override {}
+  bool IsKeyDown(int key) override { return false; }
+  bool IsKeyPressed(int key) override { return false; }
+  bool IsMouseButtonPressed(int button) override { return false; }
+
+  void BeginDrawing() override { m_frame_draw_calls = 0; }
+  void EndDrawing() override;
+  void ClearBackground(Color color) override { Count(); }
+  void BeginMode2D(Camera2D camera) override {}
+  void EndMode2D() override {}
+  void DrawLine(int startX, int startY, int endX, int endY, Color color) override { Count(); }
+  void DrawCircle(int centerX, int centerY, float radius, Color color) override { Count(); }
+  void DrawEllipseLines(int centerX, int centerY, float radiusH, float radiusV,
+                        Color color) override {
+    Count();
+  }
+  void DrawRectangle(int posX, int posY, int width, int height, Color color) override {
+    Count();
+  }
+  void DrawRectangleLines(int posX, int posY, int width, int height, Color color) override {
+    Count();
+  }
+  void DrawTriangle(Vector2 v1, Vector2 v2, Vector2 v3, Color color) override { Count(); }
+  void DrawTextureEx(Texture2D texture, Vector2 position, float rotation, float scale,
+                     Color tint) override {
+    Count();
+  }
+  void DrawText(const char *text, int posX, int posY, int fontSize, Color color) override {
+    Count();
+  }
+  int MeasureText(const char *text, int fontSize) override;
+
+  Texture2D LoadTexture(const char *filename) override;
+  Texture2D LoadTextureFromImage(Image image) override;
+  void UnloadTexture(Texture2D texture) override {}
+
+  size_t Frames() const { return m_frames; }
+  size_t DrawCalls() const { return m_draw_calls; }
+  size_t LastFrameDrawCalls() const { return m_last_frame_draw_calls; }
+
+private:
+  void Count() {
+    ++m_draw_calls;
+    ++m_frame_draw_calls;
+  }
+
+  float m_frame_time;
+  size_t m_max_frames;
+  int m_width = 0;
+  int m_height = 0;
+  size_t m_frames = 0;
+  size_t m_draw_calls = 0;
+  size_t m_frame_draw_calls = 0;
+  size_t m_last_frame_draw_calls = 0;
+};
+
+// Passes every call to another backend. Decorators derive from it and override what they change.
+class ForwardingBackend : public Backend {
+public:
+  explicit ForwardingBackend(std::unique_ptr<Backend> inner) : m_inner(std::move(inner)) {}
+
+  void InitWindow(int width, int height, const char *title) override {
+    m_inner->InitWindow(width, height, title);
+  }
+  void CloseWindow() override { m_inner->CloseWindow(); }
+  bool WindowShouldClose() override { return m_inner->WindowShouldClose(); }
+  void SetTargetFPS(int fps) override { m_inner->SetTargetFPS(fps); }
+  int GetScreenWidth() override { return m_inner->GetScreenWidth(); }
+  int GetScreenHeight() override { return m_inner->GetScreenHeight(); }
+  float GetFrameTime() override { return m_inner->GetFrameTime(); }
+  void InitAudioDevice() override { m_inner->InitAudioDevice(); }
+  void CloseAudioDevice() override { m_inner->CloseAudioDevice(); }
+
+  void SetExitKey(int key) override { m_inner->SetExitKey(key); }
+  bool IsKeyDown(int key) override { return m_inner->IsKeyDown(key); }
+  bool IsKeyPressed(int key) override { return m_inner->IsKeyPressed(key); }
+  bool IsMouseButtonPressed(int button) override { return m_inner->IsMouseButtonPressed(button); }
+
+  void BeginDrawing() override { m_inner->BeginDrawing(); }
+  void EndDrawing() override { m_inner->EndDrawing(); }
+  void ClearBackground(Color color) override { m_inner->ClearBackground(color); }
+  void BeginMode2D(Camera2D camera) override { m_inner->BeginMode2D(camera); }
+  void EndMode2D() override { m_inner->EndMode2D(); }
+  void DrawLine(int startX, int startY, int endX, int endY, Color color) override {
+    m_inner->DrawLine(startX, startY, endX, endY, color);
+  }
+  void DrawCircle(int centerX, int centerY, float radius, Color color) override {
+    m_inner->DrawCircle(centerX, centerY, radius, color);
+  }
+  void DrawEllipseLines(int centerX, int centerY, float radiusH, float radiusV,
+                        Color color) override {
+    m_inner->DrawEllipseLines(centerX, centerY, radiusH, radiusV, color);
+  }
+  void DrawRectangle(int posX, int posY, int width, int height, Color color) override {
+    m_inner->DrawRectangle(posX, posY, width, height, color);
+  }
+  void DrawRectangleLines(int posX, int posY, int width, int height, Color color) override {
+    m_inner->DrawRectangleLines(posX, posY, width, height, color);
+  }
+  void DrawTriangle(Vector2 v1, Vector2 v2, Vector2 v3, Color color) override {
+    m_inner->DrawTriangle(v1, v2, v3, color);
+  }
+  void DrawTextureEx(Texture2D texture, Vector2 position, float rotation, float scale,
+                     Color tint) override {
+    m_inner->DrawTextureEx(texture, position, rotation, scale, tint);
+  }
+  void DrawText(const char *text, int posX, int posY, int fontSize, Color color) override {
+    m_inner->DrawText(text, posX, posY, fontSize, color);
+  }
+  int MeasureText(const char *text, int fontSize) override {
+    return m_inner->MeasureText(text, fontSize);
+  }
+
+  Texture2D LoadTexture(const char *filename) override { return m_inner->LoadTexture(filename); }
+  Texture2D LoadTextureFromImage(Image image) override {
+    return m_inner->LoadTextureFromImage(image);
+  }
+  void UnloadTexture(Texture2D texture) override { m_inner->UnloadTexture(texture); }
+
+protected:
+  std::unique_ptr<Backend> m_inner;
+};
+
+// Current backend, RaylibBackend unless Set() was called
+Backend &Get();
+void Set(std::unique_ptr<Backend> backend);
+
+} // namespace Platform
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef POOL_SNAPSHOT_H
+#define POOL_SNAPSHOT_H
+
+// Two copies of what readers need of a pool. The writer fills the back copy once the systems of
+// a frame are done, Swap makes it the front copy at the frame boundary. Readers only see the
+// front copy, complete and unchanged until the next Swap, so they take no lock even while the
+// systems change the pool again.
+//
+//   snapshot.Capture(healths, [](const HealthComponent &health) { return Record{...}; });
+//   snapshot.Swap();                       // nothing reading or capturing meanwhile
+//   const Record *health = snapshot.Get(entity);
+//
+// Records are plain copies and must have an `entity` member.
+
+#include "sparse-set.hpp"
+#include <cstddef>
+#include <vector>
+
+template <typename Record> class PoolSnapshot {
+public:
+  // Back copy, the front one stays readable meanwhile. Only allocates when the pool grew.
+  // Touches the live components only: sparse slots of dead entities keep stale indices, which
+  // Get rejects by the entity of the record they point to.
+  template <typename T, typename F> void Capture(const SparseSet<T> &pool, F &&record) {
+    Buffer &back = m_buffers[1 - m_front];
+    back.records.clear();
+    back.records.reserve(pool.dense.capacity());
+    if (back.sparse.size() < pool.sparse.size()) {
+      back.sparse.reserve(pool.sparse.capacity());
+      back.sparse.resize(pool.sparse.size(), EMPTY);
+    }
+    for (const auto &component : pool.dense) {
+      back.sparse[component.entity] = back.records.size();
+      back.records.push_back(record(component));
+    }
+  }
+
+  void Swap() { m_front = 1 - m_front; }
+
+  // In the pool's dense order at capture time
+  const std::vector<Record> &Records() const { return m_buffers[m_front].records; }
+
+  const Record *Get(size_t entity) const {
+    const Buffer &front = m_buffers[m_front];
+    if (entity >= front.sparse.size() || front.sparse[entity] >= front.records.size()) {
+      return nullptr; // EMPTY too
+    }
+    const Record &record = front.records[front.sparse[entity]];
+    return record.entity == entity ? &record : nullptr;
+  }
+
+private:
+  struct Buffer {
+    std::vector<size_t> sparse;
+    std::vector<Record> records;
+  };
+
+  Buffer m_buffers[2];
+  int m_front = 0;
+};
+
+#endif
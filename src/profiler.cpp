@@ -0,0 +1,235 @@
+#include "profiler.hpp"
+
+#ifdef MINOIDS_PROFILE
+
+#include "platform.hpp"
+#include "raylib.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+namespace Profiler {
+
+static constexpr double AVERAGE_WEIGHT = .05; // of the newest frame
+static constexpr int OVERLAY_FONT_SIZE = 10;
+static constexpr int OVERLAY_INDENT = 10;
+static constexpr int OVERLAY_NAME_WIDTH = 200;
+static constexpr int OVERLAY_TIME_WIDTH = 110;
+#ifdef MINOIDS_TRACK_ALLOCS
+static constexpr int OVERLAY_ALLOCS_WIDTH = 110;
+#else
+static constexpr int OVERLAY_ALLOCS_WIDTH = 0;
+#endif
+#ifdef MINOIDS_PERF_COUNTERS
+static constexpr int OVERLAY_COUNTERS_WIDTH = 220;
+#else
+static constexpr int OVERLAY_COUNTERS_WIDTH = 0;
+#endif
+static constexpr int OVERLAY_WIDTH =
+    OVERLAY_NAME_WIDTH + OVERLAY_TIME_WIDTH + OVERLAY_ALLOCS_WIDTH + OVERLAY_COUNTERS_WIDTH;
+
+static const auto s_start = std::chrono::steady_clock::now();
+static std::atomic<Ring *> s_rings{nullptr}; // lock-free list, rings are only ever added
+static std::atomic<uint32_t> s_threads{0};
+static thread_local Ring *t_ring = nullptr;
+static thread_local uint32_t t_depth = 0;
+static std::vector<ScopeStats> s_stats; // main thread only
+
+uint64_t Now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                                                              s_start)
+      .count();
+}
+
+Ring &ThreadRing() {
+  if (!t_ring) {
+    // Never freed, the events of a finished thread can still be dumped
+    t_ring = new Ring();
+    t_ring->thread = s_threads.fetch_add(1, std::memory_order_relaxed);
+    Ring *head = s_rings.load(std::memory_order_acquire);
+    do {
+      t_ring->next = head;
+    } while (!s_rings.compare_exchange_weak(head, t_ring, std::memory_order_release,
+                                            std::memory_order_acquire));
+  }
+  return *t_ring;
+}
+
+Scope::Scope(const char *name) : m_name(name) {
+#ifdef MINOIDS_PERF_COUNTERS
+  // Counters first, so the timer does not include their syscall
+  m_counting = PerfCounters::Read(m_counters);
+#endif
+#ifdef MINOIDS_TRACK_ALLOCS
+  m_allocs = AllocTracker::ThreadCounts();
+#endif
+  m_start = Now();
+  ++t_depth;
+}
+
+Scope::~Scope() {
+  const uint64_t end = Now();
+  --t_depth;
+
+#ifdef MINOIDS_TRACK_ALLOCS
+  const AllocTracker::Counts allocs = AllocTracker::ThreadCounts();
+#endif
+
+  Ring &ring = ThreadRing();
+  const uint64_t head = ring.head.load(std::memory_order_relaxed);
+  Event &event = ring.events[head & (Ring::CAPACITY - 1)];
+  event.name = m_name;
+  event.start_ns = m_start;
+  event.duration_ns = end - m_start;
+  event.depth = t_depth;
+#ifdef MINOIDS_PERF_COUNTERS
+  PerfCounters::Sample sample;
+  const bool counted = m_counting && PerfCounters::Read(sample);
+  for (int c = 0; c < PerfCounters::COUNT; c++) {
+    event.counters[c] = counted ? sample.values[c] - m_counters.values[c] : 0;
+  }
+#endif
+#ifdef MINOIDS_TRACK_ALLOCS
+  event.allocs = {allocs.allocations - m_allocs.allocations, allocs.bytes - m_allocs.bytes};
+#endif
+  ring.head.store(head + 1, std::memory_order_release);
+}
+
+// Oldest event of a ring that was not overwritten yet
+static uint64_t Oldest(const Ring &ring, uint64_t head) {
+  return head > Ring::CAPACITY ? head - Ring::CAPACITY : 0;
+}
+
+void EndFrame() {
+  for (auto &stats : s_stats) {
+    stats.ms = 0.;
+    stats.calls = 0;
+#ifdef MINOIDS_PERF_COUNTERS
+    for (auto &counter : stats.counters) {
+      counter = 0.;
+    }
+#endif
+#ifdef MINOIDS_TRACK_ALLOCS
+    stats.allocations = 0;
+    stats.bytes = 0;
+#endif
+  }
+
+  for (Ring *ring = s_rings.load(std::memory_order_acquire); ring; ring = ring->next) {
+    const uint64_t head = ring->head.load(std::memory_order_acquire);
+    for (uint64_t i = std::max(ring->frame_mark, Oldest(*ring, head)); i < head; i++) {
+      const Event &event = ring->events[i & (Ring::CAPACITY - 1)];
+      auto stats = std::find_if(s_stats.begin(), s_stats.end(),
+                                [&event](const ScopeStats &s) { return s.name == event.name; });
+      if (stats == s_stats.end()) {
+        s_stats.push_back({event.name, 0., 0., 0, event.depth});
+        stats = s_stats.end() - 1;
+      }
+      stats->ms += event.duration_ns / 1e6;
+      stats->calls++;
+      stats->depth = std::min(stats->depth, event.depth);
+#ifdef MINOIDS_PERF_COUNTERS
+      for (int c = 0; c < PerfCounters::COUNT; c++) {
+        stats->counters[c] += event.counters[c];
+      }
+#endif
+#ifdef MINOIDS_TRACK_ALLOCS
+      stats->allocations += event.allocs.allocations;
+      stats->bytes += event.allocs.bytes;
+#endif
+    }
+    ring->frame_mark = head;
+  }
+
+  for (auto &stats : s_stats) {
+    stats.avg_ms += (stats.ms - stats.avg_ms) * AVERAGE_WEIGHT;
+  }
+}
+
+const std::vector<ScopeStats> &FrameStats() { return s_stats; }
+
+void DrawOverlay(int x, int y) {
+  auto &platform = Platform::Get();
+  const int line = OVERLAY_FONT_SIZE + 2;
+#ifdef MINOIDS_TRACK_ALLOCS
+  const int lines = s_stats.size() + 1;
+#else
+  const int lines = s_stats.size();
+#endif
+  platform.DrawRectangle(x - 4, y - 4, OVERLAY_WIDTH, lines * line + 8, Fade(RAYWHITE, .8f));
+
+#ifdef MINOIDS_TRACK_ALLOCS
+  const AllocTracker::Counts frame = AllocTracker::LastFrame();
+  platform.DrawText(TextFormat("Frame allocations: %llu (%llu bytes)",
+                               static_cast<unsigned long long>(frame.allocations),
+                               static_cast<unsigned long long>(frame.bytes)),
+                    x, y, OVERLAY_FONT_SIZE, frame.allocations > 0 ? MAROON : BLACK);
+  y += line;
+#endif
+
+  for (const auto &stats : s_stats) {
+    int column = x + OVERLAY_NAME_WIDTH;
+    platform.DrawText(stats.name, x + stats.depth * OVERLAY_INDENT, y, OVERLAY_FONT_SIZE, BLACK);
+    platform.DrawText(TextFormat("%6.3f ms  x%u", stats.avg_ms, stats.calls), column, y,
+                      OVERLAY_FONT_SIZE, BLACK);
+    column += OVERLAY_TIME_WIDTH;
+#ifdef MINOIDS_TRACK_ALLOCS
+    platform.DrawText(TextFormat("%llu allocs", static_cast<unsigned long long>(stats.allocations)),
+                      column, y, OVERLAY_FONT_SIZE, stats.allocations > 0 ? MAROON : DARKGRAY);
+    column += OVERLAY_ALLOCS_WIDTH;
+#endif
+#ifdef MINOIDS_PERF_COUNTERS
+    using namespace PerfCounters;
+    const double *counters = stats.counters;
+    if (counters[CYCLES] > 0.) {
+      platform.DrawText(TextFormat("IPC %.2f  L1D %.1fk  LLC %.1fk  BR %.1fk",
+                                   counters[INSTRUCTIONS] / counters[CYCLES],
+                                   counters[L1D_MISSES] / 1e3, counters[LLC_MISSES] / 1e3,
+                                   counters[BRANCH_MISSES] / 1e3),
+                        column, y, OVERLAY_FONT_SIZE, DARKGRAY);
+    }
+#endif
+    y += line;
+  }
+}
+
+bool WriteChromeTrace(const char *path) {
+  FILE *file = std::fopen(path, "w");
+  if (!file) {
+    return false;
+  }
+
+  std::fprintf(file, "{\"traceEvents\":[\n");
+  bool first = true;
+  for (Ring *ring = s_rings.load(std::memory_order_acquire); ring; ring = ring->next) {
+    const uint64_t head = ring->head.load(std::memory_order_acquire);
+    for (uint64_t i = Oldest(*ring, head); i < head; i++) {
+      const Event &event = ring->events[i & (Ring::CAPACITY - 1)];
+      std::fprintf(file,
+                   "%s{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,"
+                   "\"tid\":%u",
+                   first ? "" : ",\n", event.name, event.start_ns / 1e3,
+                   event.duration_ns / 1e3, ring->thread);
+#ifdef MINOIDS_PERF_COUNTERS
+      if (event.counters[PerfCounters::CYCLES] > 0) { // 0 when the counters are unavailable
+        std::fprintf(file, ",\"args\":{");
+        for (int c = 0; c < PerfCounters::COUNT; c++) {
+          std::fprintf(file, "%s\"%s\":%llu", c ? "," : "",
+                       PerfCounters::Name(static_cast<PerfCounters::Counter>(c)),
+                       static_cast<unsigned long long>(event.counters[c]));
+        }
+        std::fprintf(file, "}");
+      }
+#endif
+      std::fprintf(file, "}");
+      first = false;
+    }
+  }
+  std::fprintf(file, "\n]}\n");
+
+  return std::fclose(file) == 0;
+}
+
+} // namespace Profiler
+
+#endif
@@ -0,0 +1,127 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+// Scoped timers for systems and scene phases.
+// Build with MINOIDS_PROFILE to enable them, otherwise PROFILE_SCOPE expands to nothing and the
+// functions below are empty inlines. MINOIDS_PERF_COUNTERS adds hardware counters to every scope,
+// MINOIDS_TRACK_ALLOCS the allocations made inside it.
+//
+//   void Registry::PositionSystem() {
+//     PROFILE_SCOPE("PositionSystem");
+//     ...
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#ifdef MINOIDS_PROFILE
+#include <atomic>
+#endif
+
+#ifdef MINOIDS_PERF_COUNTERS
+#ifndef MINOIDS_PROFILE
+#error "MINOIDS_PERF_COUNTERS needs MINOIDS_PROFILE"
+#endif
+#include "perf-counters.hpp"
+#endif
+
+#ifdef MINOIDS_TRACK_ALLOCS
+#include "alloc-tracker.hpp"
+#endif
+
+namespace Profiler {
+
+// Aggregated over one frame, for the overlay
+struct ScopeStats {
+  const char *name;
+  double ms;     // last frame
+  double avg_ms; // smoothed over recent frames
+  uint32_t calls;
+  uint32_t depth;
+#ifdef MINOIDS_PERF_COUNTERS
+  double counters[PerfCounters::COUNT]; // last frame
+#endif
+#ifdef MINOIDS_TRACK_ALLOCS
+  uint64_t allocations; // last frame
+  uint64_t bytes;
+#endif
+};
+
+#ifdef MINOIDS_PROFILE
+
+struct Event {
+  const char *name; // string literal, compared by address
+  uint64_t start_ns;
+  uint64_t duration_ns;
+  uint32_t depth;
+#ifdef MINOIDS_PERF_COUNTERS
+  uint64_t counters[PerfCounters::COUNT]; // during the scope
+#endif
+#ifdef MINOIDS_TRACK_ALLOCS
+  AllocTracker::Counts allocs; // during the scope
+#endif
+};
+
+// Single producer ring, one per thread. The owning thread publishes events with a release
+// store of `head`, readers copy what is behind it. Old events are overwritten.
+struct Ring {
+  static constexpr size_t CAPACITY = 1 << 14; // power of two
+
+  Event events[CAPACITY];
+  std::atomic<uint64_t> head{0};
+  uint64_t frame_mark = 0; // first event of the current frame, used by EndFrame
+  uint32_t thread;
+  Ring *next = nullptr; // all rings, see Rings()
+};
+
+uint64_t Now(); // ns since start
+Ring &ThreadRing();
+
+class Scope {
+public:
+  explicit Scope(const char *name);
+  ~Scope();
+
+  Scope(const Scope &) = delete;
+  Scope &operator=(const Scope &) = delete;
+
+private:
+  const char *m_name;
+  uint64_t m_start;
+#ifdef MINOIDS_PERF_COUNTERS
+  PerfCounters::Sample m_counters;
+  bool m_counting;
+#endif
+#ifdef MINOIDS_TRACK_ALLOCS
+  AllocTracker::Counts m_allocs;
+#endif
+};
+
+// Call once per frame, after the frame is drawn
+void EndFrame();
+const std::vector<ScopeStats> &FrameStats();
+void DrawOverlay(int x, int y);
+// Chrome trace_event JSON (chrome://tracing, ui.perfetto.dev) of every event still in the rings
+bool WriteChromeTrace(const char *path);
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(name) ::Profiler::Scope PROFILE_CONCAT(profile_scope_, __LINE__)(name)
+
+#else
+
+inline void EndFrame() {}
+inline const std::vector<ScopeStats> &FrameStats() {
+  static const std::vector<ScopeStats> s_empty;
+  return s_empty;
+}
+inline void DrawOverlay(int x, int y) {}
+inline bool WriteChromeTrace(const char *path) { return false; }
+
+#define PROFILE_SCOPE(name)
+
+#endif
+
+} // namespace Profiler
+
+#endif
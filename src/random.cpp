@@ -0,0 +1,28 @@
+#include "random.hpp"
+#include <random>
+
+namespace Random {
+
+static uint64_t s_master = 0;
+static Generator s_streams[STREAM_COUNT];
+
+// The only random_device of the game, read once at startup
+static const bool s_seeded = [] {
+  std::random_device device;
+  Seed(static_cast<uint64_t>(device()) << 32 | device());
+  return true;
+}();
+
+void Seed(uint64_t master) {
+  s_master = master;
+  for (int stream = 0; stream < STREAM_COUNT; stream++) {
+    // Streams far apart in splitmix64's sequence, so their states are unrelated
+    s_streams[stream].Seed(master ^ (static_cast<uint64_t>(stream + 1) << 56));
+  }
+}
+
+uint64_t MasterSeed() { return s_master; }
+
+Generator &Get(Stream stream) { return s_streams[stream]; }
+
+} // namespace Random
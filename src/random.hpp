@@ -0,0 +1,85 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+// Every random draw of the game comes from here. One master seed (Seed) derives an independent
+// stream per system, so adding draws to one system does not change what the others see, and
+// the whole session is reproducible from the seed (see input-replay.hpp).
+//
+//   auto &rng = Random::Get(Random::PARTICLES);
+//   float speed = rng.Float(5.f, 10.f);
+//
+// A stream is not thread safe, it belongs to one thread at a time.
+
+#include <cstdint>
+
+namespace Random {
+
+// xoshiro128** by Blackman and Vigna: 16 bytes of state, a few cycles per draw, no syscall.
+// Also a UniformRandomBitGenerator for the <random> algorithms.
+class Generator {
+public:
+  using result_type = uint32_t;
+
+  Generator() { Seed(0); }
+  explicit Generator(uint64_t seed) { Seed(seed); }
+
+  // State from splitmix64, as the authors recommend, never all zero
+  void Seed(uint64_t seed) {
+    for (auto &word : m_state) {
+      seed += 0x9e3779b97f4a7c15;
+      uint64_t z = seed;
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+      word = static_cast<uint32_t>(z ^ (z >> 31));
+    }
+  }
+
+  uint32_t operator()() {
+    const uint32_t result = Rotl(m_state[1] * 5, 7) * 9;
+    const uint32_t t = m_state[1] << 9;
+    m_state[2] ^= m_state[0];
+    m_state[3] ^= m_state[1];
+    m_state[1] ^= m_state[2];
+    m_state[0] ^= m_state[3];
+    m_state[2] ^= t;
+    m_state[3] = Rotl(m_state[3], 11);
+    return result;
+  }
+
+  static constexpr uint32_t min() { return 0; }
+  static constexpr uint32_t max() { return UINT32_MAX; }
+
+  // [0, 1)
+  float Float() { return ((*this)() >> 8) * (1.f / (1 << 24)); }
+  // [lo, hi)
+  float Float(float lo, float hi) { return lo + (hi - lo) * Float(); }
+  // [lo, hi], multiply-shift: the bias is below 2^-32 * range, fine for gameplay
+  int Int(int lo, int hi) {
+    const uint64_t range = static_cast<uint64_t>(static_cast<int64_t>(hi) - lo) + 1;
+    return lo + static_cast<int>((static_cast<uint64_t>((*this)()) * range) >> 32);
+  }
+
+private:
+  static uint32_t Rotl(uint32_t x, int k) { return (x << k) | (x >> (32 - k)); }
+
+  uint32_t m_state[4];
+};
+
+enum Stream {
+  LEVEL,      // cores to gather per level
+  METEORS,    // world seed: meteor placement, size and velocity, see world.hpp
+  SHAPES,     // meteor outline profiles
+  PARTICLES,  // collision particles
+  BACKGROUND, // backdrop nebula and stars, see background.hpp
+  STREAM_COUNT
+};
+
+// Reseeds every stream. Random until called.
+void Seed(uint64_t master);
+uint64_t MasterSeed();
+
+Generator &Get(Stream stream);
+
+} // namespace Random
+
+#endif
@@ -0,0 +1,122 @@
+#include "render-list.hpp"
+#include "profiler.hpp"
+
+namespace ECS {
+
+// A busy frame's worth up front. Each list is only filled every other frame, growing it then
+// would be a steady frame allocation.
+static constexpr size_t INITIAL_COMMANDS = 4096;
+static constexpr size_t INITIAL_POINTS = 16384; // meteor outlines
+static constexpr size_t INITIAL_TEXTURES = 64;
+static constexpr size_t INITIAL_CHARS = 4096;
+
+RenderList::RenderList() {
+  m_commands.reserve(INITIAL_COMMANDS);
+  m_cameras.reserve(1);
+  m_points.reserve(INITIAL_POINTS);
+  m_textures.reserve(INITIAL_TEXTURES);
+  m_chars.reserve(INITIAL_CHARS);
+}
+
+void RenderList::Clear() {
+  m_commands.clear();
+  m_cameras.clear();
+  m_points.clear();
+  m_textures.clear();
+  m_chars.clear();
+}
+
+void RenderList::BeginMode2D(const Camera2D &camera) {
+  m_commands.push_back({Kind::BEGIN_MODE_2D, {}, {}, {}, static_cast<uint32_t>(m_cameras.size())});
+  m_cameras.push_back(camera);
+}
+
+void RenderList::EndMode2D() { m_commands.push_back({Kind::END_MODE_2D}); }
+
+void RenderList::DrawLine(Vector2 from, Vector2 to, Color color) {
+  m_commands.push_back({Kind::LINE, color, from, to});
+}
+
+void RenderList::DrawCircle(Vector2 center, float radius, Color color) {
+  m_commands.push_back({Kind::CIRCLE, color, center, {radius, radius}});
+}
+
+void RenderList::DrawEllipseLines(Vector2 center, float radius_h, float radius_v, Color color) {
+  m_commands.push_back({Kind::ELLIPSE_LINES, color, center, {radius_h, radius_v}});
+}
+
+void RenderList::DrawRectangle(Vector2 at, Vector2 size, Color color) {
+  m_commands.push_back({Kind::RECTANGLE, color, at, size});
+}
+
+void RenderList::DrawRectangleLines(Vector2 at, Vector2 size, Color color) {
+  m_commands.push_back({Kind::RECTANGLE_LINES, color, at, size});
+}
+
+void RenderList::DrawTriangleFan(Vector2 center, const Vector2 *outline, size_t count,
+                                 Color color) {
+  m_commands.push_back({Kind::TRIANGLE_FAN, color, center, {},
+                        static_cast<uint32_t>(m_points.size()), static_cast<uint32_t>(count)});
+  m_points.insert(m_points.end(), outline, outline + count);
+}
+
+void RenderList::DrawTextureEx(const Texture2D &texture, Vector2 at, float scale, Color tint) {
+  m_commands.push_back(
+      {Kind::TEXTURE, tint, at, {scale, 0.f}, static_cast<uint32_t>(m_textures.size())});
+  m_textures.push_back(texture);
+}
+
+void RenderList::DrawText(std::string_view text, Vector2 at, int font_size, Color color) {
+  m_commands.push_back({Kind::TEXT, color, at, {static_cast<float>(font_size), 0.f},
+                        static_cast<uint32_t>(m_chars.size())});
+  m_chars.insert(m_chars.end(), text.begin(), text.end());
+  m_chars.push_back('\0');
+}
+
+void RenderList::Submit() const {
+  PROFILE_SCOPE("RenderList::Submit");
+  auto &platform = Platform::Get();
+  for (const auto &command : m_commands) {
+    const Vector2 at = command.at;
+    const Vector2 size = command.size;
+    switch (command.kind) {
+    case Kind::BEGIN_MODE_2D:
+      platform.BeginMode2D(m_cameras[command.first]);
+      break;
+    case Kind::END_MODE_2D:
+      platform.EndMode2D();
+      break;
+    case Kind::LINE:
+      platform.DrawLine(at.x, at.y, size.x, size.y, command.color);
+      break;
+    case Kind::CIRCLE:
+      platform.DrawCircle(at.x, at.y, size.x, command.color);
+      break;
+    case Kind::ELLIPSE_LINES:
+      platform.DrawEllipseLines(at.x, at.y, size.x, size.y, command.color);
+      break;
+    case Kind::RECTANGLE:
+      platform.DrawRectangle(at.x, at.y, size.x, size.y, command.color);
+      break;
+    case Kind::RECTANGLE_LINES:
+      platform.DrawRectangleLines(at.x, at.y, size.x, size.y, command.color);
+      break;
+    case Kind::TRIANGLE_FAN: {
+      const Vector2 *outline = &m_points[command.first];
+      for (uint32_t i = 0; i < command.count; i++) {
+        platform.DrawTriangle(at, outline[(i + 1) % command.count], outline[i], command.color);
+      }
+      break;
+    }
+    case Kind::TEXTURE:
+      platform.DrawTextureEx(m_textures[command.first], at, 0.f, size.x, command.color);
+      break;
+    case Kind::TEXT:
+      platform.DrawText(&m_chars[command.first], at.x, at.y, static_cast<int>(size.x),
+                        command.color);
+      break;
+    }
+  }
+}
+
+} // namespace ECS
@@ -0,0 +1,79 @@
+#ifndef RENDER_LIST_H
+#define RENDER_LIST_H
+
+// Draw calls recorded for later, so a frame can be built on a worker from the simulation state
+// and submitted on the main thread while the next step already runs. Recording does the
+// interpolation, culling and meteor outlines; Submit only issues the Platform calls, in order.
+//
+//   list.Clear();                  // reuses the buffers, no allocation once warmed up
+//   registry.RenderSystem(list, screen);
+//   list.Submit();                 // main thread, between BeginDrawing and EndDrawing
+//
+// Textures are drawn by value: they must outlive the list's next Submit.
+
+#include "platform.hpp"
+#include "raylib.h"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace ECS {
+
+class RenderList {
+public:
+  RenderList();
+
+  void Clear();
+
+  // Commands until EndMode2D are in world space
+  void BeginMode2D(const Camera2D &camera);
+  void EndMode2D();
+
+  void DrawLine(Vector2 from, Vector2 to, Color color);
+  void DrawCircle(Vector2 center, float radius, Color color);
+  void DrawEllipseLines(Vector2 center, float radius_h, float radius_v, Color color);
+  void DrawRectangle(Vector2 at, Vector2 size, Color color);
+  void DrawRectangleLines(Vector2 at, Vector2 size, Color color);
+  // Solid fan from `center` through the `count` points of a closed outline
+  void DrawTriangleFan(Vector2 center, const Vector2 *outline, size_t count, Color color);
+  void DrawTextureEx(const Texture2D &texture, Vector2 at, float scale, Color tint);
+  void DrawText(std::string_view text, Vector2 at, int font_size, Color color);
+
+  size_t Size() const { return m_commands.size(); }
+
+  void Submit() const;
+
+private:
+  enum class Kind : uint8_t {
+    BEGIN_MODE_2D,
+    END_MODE_2D,
+    LINE,
+    CIRCLE,
+    ELLIPSE_LINES,
+    RECTANGLE,
+    RECTANGLE_LINES,
+    TRIANGLE_FAN,
+    TEXTURE,
+    TEXT,
+  };
+
+  struct Command {
+    Kind kind;
+    Color color;
+    Vector2 at;
+    Vector2 size;   // line end, radii, width/height, x: texture scale or font size
+    uint32_t first; // into m_cameras, m_points, m_textures or m_chars
+    uint32_t count; // TRIANGLE_FAN: outline points
+  };
+
+  std::vector<Command> m_commands;
+  std::vector<Camera2D> m_cameras;
+  std::vector<Vector2> m_points;
+  std::vector<Texture2D> m_textures;
+  std::vector<char> m_chars; // texts, zero terminated
+};
+
+} // namespace ECS
+
+#endif
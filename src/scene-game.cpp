@@ -1,41 +1,80 @@
+#include "background.hpp"
 #include "ecs.hpp"
 #include "fmt/core.h"
 #include "game.hpp"
+#include "profiler.hpp"
+#include "random.hpp"
 #include "raylib.h"
+#include "raymath.h"
+#include "render-list.hpp"
 #include "scenes.hpp"
+#include "system-schedule.hpp"
+#include "world.hpp"
+#include <algorithm>
+#include <iterator>
 #include <memory>
 #include <random>
 #include <variant>
 #include <vector>
 
-constexpr static float METEORS_WINDOW_PADDING = 50.f;
 constexpr static Vector2 SPACESHIP_SIZE{61.f, 29.f}; // matches sprite dimensions
 constexpr static float MAX_PUSH_FORCE = 5.f;
 constexpr static float PUSH_FORCE_STEP = .2f;
 constexpr static float PUSH_FORCE_STEP_HALF = PUSH_FORCE_STEP / 2.f;
 
-constexpr static int METEOR_POINT_COUNT = 80;
+constexpr static float BACKGROUND_PARALLAX = .15f; // backdrop moves this much of the ship's step
+constexpr static Vector2 BACKGROUND_DRIFT{.05f, .02f}; // per step, space is never quite still
+
 constexpr static float METEOR_NOISE_AMPLITUDE = 8.1f;
+constexpr static float METEOR_RESTITUTION = .8f;
+
+// WORLD: chunks this close to the ship's are simulated, and kept until they are further than
+// KEEP_CHUNKS, see world.hpp
+constexpr static int ACTIVE_CHUNKS = 1;
+constexpr static int KEEP_CHUNKS = 2;
+constexpr static int PREFETCH_CHUNKS = 2;
+constexpr static int MIN_METEORS_PER_CHUNK = 1;
+constexpr static int KEPT_CHUNKS = (2 * KEEP_CHUNKS + 1) * (2 * KEEP_CHUNKS + 1); // at most
+constexpr static float START_CLEAR_RADIUS = 150.f; // around the ship
 
 static SceneEvent s_Event = SceneEvent::NONE;
 static bool s_IsFocused = false;
 
 static std::unique_ptr<ECS::Registry> s_Registry;
+static std::unique_ptr<ECS::Schedule> s_schedule; // StepGame's systems, see BuildSchedule
+static ECS::Schedule::System s_inputSystem;
+
+// Schedule resources outside the registry
+constexpr static ECS::Access GAME = ECS::Resource::USER; // g_Game, the entity lists, World
+constexpr static ECS::Access BACKDROP = ECS::Resource::USER << 1; // Background
+
+// FRAMES: BuildGameFrame fills one after the simulation while DrawGame submits the other. The
+// Registry's snapshots are captured and swapped with them.
+struct Frame {
+  ECS::RenderList list;
+  Vector2 backdrop; // Background offset
+  Camera2D camera;
+  float alpha; // interpolation
+};
+static Frame s_frames[2];
+static int s_drawn = 0; // DrawGame's frame
+static Vector2 s_screen{};
+
+// INSPECTOR (F2): meteor and core healths over the drawn frame, from the snapshots
+static bool s_inspector = false;
 
 using ECS::PositionComponent, ECS::RenderComponent, ECS::TextComponent, ECS::VelocityComponent,
     ECS::GameStateComponent, ECS::UIComponent, ECS::ForceComponent, ECS::DmgComponent,
     ECS::ColliderComponent, ECS::WeaponComponent, ECS::HealthComponent, ECS::SpriteComponent,
-    ECS::EmitterComponent, ECS::UIElement, ECS::Entity, ECS::Layer, ECS::Shape;
-
-// ENTROPY
-static std::random_device rd;
-static std::mt19937 gen(rd());
+    ECS::EmitterComponent, ECS::BodyComponent, ECS::UIElement, ECS::Entity, ECS::Layer, ECS::Shape;
+namespace CollisionLayer = ECS::CollisionLayer;
 
 // STATE
 enum class GameState { PLAY, PAUSE, WON, LOST };
 static bool s_isFiring = false;
 static float s_firingDuration = 0.f;
 static GameState s_state = GameState::PLAY;
+static bool s_shipLost = false; // a life was lost, the spaceship resets on the next step
 
 // ENTITIES
 static Entity s_spaceshipHealth;
@@ -49,182 +88,159 @@ static Entity s_coresCount;
 static Entity s_level;
 static std::vector<Entity> s_meteors;
 static std::vector<Entity> s_cores;
+static std::vector<World::Chunk> s_residentChunks;
+static std::vector<World::Meteor> s_spawns; // reused by StreamChunks
 
 constexpr static size_t FRAME_MAX_COUNTER = 3600;
 static size_t s_frame = 0;
 
 extern Game::Game g_Game;
 
-void LoadGame() {
-  float screen_cw = GetScreenWidth() / 2.f;
-  float screen_ch = GetScreenHeight() / 2.f;
-  float meteors_offset = Game::MAX_METEOR_SIZE + METEORS_WINDOW_PADDING;
-
-  s_Registry = std::make_unique<ECS::Registry>();
-  s_Registry->Init();
-
-  // Randomizers
-  std::uniform_real_distribution<float> rnd_x(meteors_offset, (float)GetScreenWidth() - meteors_offset);
-  std::uniform_real_distribution<float> rnd_y(meteors_offset, (float)GetScreenHeight() - meteors_offset);
-  std::uniform_int_distribution<int> rnd_size(g_Game.meteors.min_meteor_size,
-                                                 g_Game.meteors.max_meteor_size);
-  std::uniform_real_distribution<float> rnd_velocity(g_Game.meteors.meteor_min_velocity,
-                                                     g_Game.meteors.meteor_max_velocity);
-
-  // Our Hero
-  s_spaceShip = s_Registry->CreateEntity();
-  s_Registry->Add<PositionComponent>(s_spaceShip, screen_cw, screen_ch);
-  // s_Registry->Add<RenderComponent>(s_spaceShip, Layer::GROUND, Shape::ELLIPSE, BLACK,
-  //                                  SPACESHIP_SIZE.x, SPACESHIP_SIZE.y);
-  s_Registry->Add<SpriteComponent>(s_spaceShip, Layer::GROUND, "ufo.png");
-  s_Registry->Add<ColliderComponent>(s_spaceShip, SPACESHIP_SIZE.x, SPACESHIP_SIZE.y);
-  s_Registry->Add<DmgComponent>(s_spaceShip, 0.1f);
-  s_Registry->Add<HealthComponent>(s_spaceShip, g_Game.health);
-  s_Registry->Add<ForceComponent>(s_spaceShip, 0.f, 0.f); // Initialize empty force
-  s_Registry->Add<ECS::InputComponent>(s_spaceShip, PUSH_FORCE_STEP, MAX_PUSH_FORCE);
-
-  // Spaceship's Mining Beam
-  s_miningBeam = s_Registry->CreateEntity();
-  s_Registry->Add<PositionComponent>(s_miningBeam, 0.f, 0.f);
-  s_Registry->Add<WeaponComponent>(s_miningBeam, s_spaceShip, Game::WEAPON_MAX_DISTANCE);
-  s_Registry->Add<DmgComponent>(s_miningBeam, Game::WEAPON_DMG);
-  // s_Registry->Add<EmitterComponent>(s_miningBeam, 15 /* emmission rate */,
-  //                                   50 /* particle lifetime */, Shape::LINE,
-  //                                   Vector2{0.f, 1.f} /* particle velocity */);
+// Formats into the existing string, so per step HUD updates reuse its buffer
+template <typename... T>
+static void SetText(TextComponent *text, fmt::format_string<T...> format, T &&...args) {
+  text->value.clear();
+  fmt::format_to(std::back_inserter(text->value), format, std::forward<T>(args)...);
+}
 
-  // Generate Meteors
-  s_meteors = std::vector<Entity>();
-  s_meteors.reserve(g_Game.meteors.count);
-  s_cores = std::vector<Entity>();
-  s_cores.reserve(s_meteors.capacity());
-
-  for (int i = 0; i < s_meteors.capacity(); i++) {
-    float posX = rnd_x(gen);
-    float posY = rnd_y(gen);
-    float velX = rnd_velocity(gen);
-    float velY = rnd_velocity(gen);
-    float radius = (float)rnd_size(gen);
-
-    // Meteor Core
-    s_cores.push_back(s_Registry->CreateEntity());
-    Entity core = s_cores.back();
-    s_Registry->Add<PositionComponent>(core, posX, posY);
-    s_Registry->Add<VelocityComponent>(core, velX, velY);
-    s_Registry->Add<RenderComponent>(core, Layer::SUB, Shape::CIRCLE, DARKGREEN, 0.f);
-    s_Registry->Add<HealthComponent>(core, Game::METEOR_CORE_HEALTH);
-    // NO Collider until core revealed
-
-    // Main Meteor
-    s_meteors.push_back(s_Registry->CreateEntity());
-    Entity meteor = s_meteors.back();
-    s_Registry->Add<PositionComponent>(meteor, posX, posY);
-    // TODO: bigger asteroids should move slower
-    s_Registry->Add<VelocityComponent>(meteor, velX, velY);
-    s_Registry->Add<RenderComponent>(meteor, Layer::GROUND, Shape::METEOR, BLACK, radius,
-                                     METEOR_NOISE_AMPLITUDE, METEOR_POINT_COUNT);
-    s_Registry->Add<ColliderComponent>(meteor, radius);
-    s_Registry->Add<HealthComponent>(meteor, radius); // bigger means more health
-    s_Registry->Add<DmgComponent>(meteor, Game::METEOR_DMG);
+// A meteor and its hidden core, the core's entity right before the meteor's. Only the revealed
+// core when the record has no radius.
+static void SpawnMeteor(const World::Meteor &record) {
+  const auto [x, y] = record.position;
+  const auto [vel_x, vel_y] = record.velocity;
+
+  // Meteor Core
+  s_cores.push_back(s_Registry->CreateEntity());
+  Entity core = s_cores.back();
+  s_Registry->Add<PositionComponent>(core, x, y);
+  s_Registry->Add<VelocityComponent>(core, vel_x, vel_y);
+  s_Registry->Add<HealthComponent>(core, Game::METEOR_CORE_HEALTH);
+  if (record.radius == 0.f) {
+    s_Registry->Add<RenderComponent>(core, Layer::SUB, Shape::CIRCLE, DARKGREEN,
+                                     Game::METEOR_CORE_SIZE);
+    s_Registry->Add<ColliderComponent>(core, Game::METEOR_CORE_SIZE, CollisionLayer::CORE,
+                                       CollisionLayer::CORE_MASK);
+    return;
   }
+  s_Registry->Add<RenderComponent>(core, Layer::SUB, Shape::CIRCLE, DARKGREEN, 0.f);
+  // NO Collider until core revealed
+
+  // Main Meteor
+  s_meteors.push_back(s_Registry->CreateEntity());
+  Entity meteor = s_meteors.back();
+  s_Registry->Add<PositionComponent>(meteor, x, y);
+  // TODO: bigger asteroids should move slower
+  s_Registry->Add<VelocityComponent>(meteor, vel_x, vel_y);
+  s_Registry->Add<RenderComponent>(meteor, Layer::GROUND, Shape::METEOR, BLACK, record.radius,
+                                   METEOR_NOISE_AMPLITUDE, record.profile);
+  s_Registry->Add<ColliderComponent>(meteor, Shape::METEOR, record.radius, METEOR_NOISE_AMPLITUDE,
+                                     CollisionLayer::METEOR, CollisionLayer::METEOR_MASK);
+  s_Registry->Add<BodyComponent>(meteor, METEOR_RESTITUTION);
+  s_Registry->Add<HealthComponent>(meteor, record.radius); // bigger means more health
+  s_Registry->Add<DmgComponent>(meteor, Game::METEOR_DMG);
+}
 
-  // State: Spaceship health (UI Entity)
-  s_spaceshipHealth = s_Registry->CreateEntity();
-  s_Registry->Add<GameStateComponent>(s_spaceshipHealth, g_Game.health);
-  s_Registry->Add<UIComponent>(s_spaceshipHealth, UIElement::BAR, DARKGREEN);
-  s_Registry->Add<PositionComponent>(s_spaceshipHealth, 10.f, 10.f);
-
-  // Spaceship Lives (UI Entity)
-  s_spaceshipLives = s_Registry->CreateEntity();
-  s_Registry->Add<GameStateComponent>(s_spaceshipLives, g_Game.lives);
-  s_Registry->Add<TextComponent>(s_spaceshipLives, fmt::format("{} Lives", g_Game.lives), MAROON);
-  s_Registry->Add<PositionComponent>(s_spaceshipLives,
-                                     GetScreenWidth() - MeasureText(" Lives", 20) - 20.f, 10.f);
-
-  // Fuel (UI Entity)
-  // s_spaceshipFuel = s_Registry->CreateEntity();
-  // s_Registry->Add<GameStateComponent>(s_spaceshipFuel, g_Game.fuel);
-  // s_Registry->Add<UIComponent>(s_spaceshipFuel, UIElement::BAR, BLACK);
-  // s_Registry->Add<PositionComponent>(s_spaceshipFuel, 10.f, 30.f);
-
-  // Scores (UI Entity)
-  s_score = s_Registry->CreateEntity();
-  s_Registry->Add<GameStateComponent>(s_score, g_Game.score);
-  s_Registry->Add<TextComponent>(s_score, fmt::format("{}", g_Game.score), BROWN);
-  s_Registry->Add<PositionComponent>(s_score, screen_cw - 10.f, 10.f);
-
-  // # Cores (UI Entity)
-  s_coresCount = s_Registry->CreateEntity();
-  s_Registry->Add<GameStateComponent>(s_coresCount, g_Game.total_cores);
-  s_Registry->Add<TextComponent>(s_coresCount, fmt::format("{} Cores", g_Game.total_cores),
-                                 DARKGREEN);
-  s_Registry->Add<PositionComponent>(s_coresCount, screen_cw * 1.5f, 10.f);
-
-  // Level (UI Entity)
-  s_level = s_Registry->CreateEntity();
-  s_Registry->Add<GameStateComponent>(s_level, g_Game.level);
-  s_Registry->Add<TextComponent>(s_level, fmt::format("L {}", g_Game.level), DARKBLUE);
-  s_Registry->Add<PositionComponent>(s_level, 140.f, 10.f);
-
-  s_IsFocused = true;
+// Removes `entity` from the simulation and from `entities`
+static void Despawn(std::vector<Entity> &entities, Entity entity) {
+  s_Registry->DeleteEntity(entity);
+  entities.erase(std::find(entities.begin(), entities.end(), entity));
 }
 
-void UpdateGame(float delta) {
-  // check if round is won or lost
-  if (Game::IsGameWon()) {
-    s_state = GameState::WON;
-    s_Event = SceneEvent::NEXT;
-    return;
-  } else {
-    auto lives = s_Registry->Get<GameStateComponent>(s_spaceshipLives);
-    if (Game::IsGameLost()) {
-      s_state = GameState::LOST;
-      s_Event = SceneEvent::NEXT;
-      return;
+// Simulates the chunks around the ship: what left them goes back to the World as records, the
+// chunks it approaches are spawned
+static void StreamChunks() {
+  PROFILE_SCOPE("StreamChunks");
+  const World::Chunk center =
+      World::ChunkAt(s_Registry->Get<PositionComponent>(s_spaceShip)->value);
+
+  // Meteors, with their hidden core
+  for (size_t i = 0; i < s_meteors.size();) {
+    const Entity meteor = s_meteors[i];
+    const auto pos = s_Registry->Get<PositionComponent>(meteor);
+    const World::Chunk chunk = World::ChunkAt(pos->value);
+    if (World::InRange(chunk, center, KEEP_CHUNKS) ||
+        !World::Store(chunk, {pos->value, s_Registry->Get<VelocityComponent>(meteor)->value,
+                              s_Registry->Get<HealthComponent>(meteor)->value,
+                              s_Registry->Get<RenderComponent>(meteor)->profile})) {
+      ++i;
+      continue;
     }
+    Despawn(s_cores, meteor - 1);
+    Despawn(s_meteors, meteor);
   }
 
-  // HANDLE INPUT only when in FOCUS
-  if (s_IsFocused) {
-    if (IsKeyPressed(KEY_ESCAPE)) {
-      s_state = GameState::PAUSE;
-      s_Event = SceneEvent::PAUSE;
-      return;
+  // Revealed cores, the hidden ones went with their meteor
+  for (size_t i = 0; i < s_cores.size();) {
+    const Entity core = s_cores[i];
+    const auto pos = s_Registry->Get<PositionComponent>(core);
+    const World::Chunk chunk = World::ChunkAt(pos->value);
+    if (!s_Registry->Get<ColliderComponent>(core) || World::InRange(chunk, center, KEEP_CHUNKS) ||
+        !World::Store(chunk,
+                      {pos->value, s_Registry->Get<VelocityComponent>(core)->value, 0.f, 0})) {
+      ++i;
+      continue;
     }
-
-    // Input
-    s_Registry->InputSystem();
+    Despawn(s_cores, core);
   }
 
-  // Handle Fuel consumption
-  // if (IsKeyDown(KEY_RIGHT) || IsKeyDown(KEY_LEFT) || IsKeyDown(KEY_UP) || IsKeyDown(KEY_DOWN)) {
-  //   Game::LoseFuel();
-  //   auto fuel = s_Registry->Get<GameStateComponent>(s_spaceshipFuel);
-  //   fuel->value = g_Game.fuel;
-  // }
+  for (auto it = s_residentChunks.begin(); it != s_residentChunks.end();) {
+    if (World::InRange(*it, center, KEEP_CHUNKS)) {
+      ++it;
+    } else {
+      World::Evict(*it);
+      it = s_residentChunks.erase(it);
+    }
+  }
 
-  if (GameState::PAUSE == s_state) {
-    return;
+  for (int y = center.y - PREFETCH_CHUNKS; y <= center.y + PREFETCH_CHUNKS; y++) {
+    for (int x = center.x - PREFETCH_CHUNKS; x <= center.x + PREFETCH_CHUNKS; x++) {
+      const World::Chunk chunk{x, y};
+      if (x < 0 || x >= World::CHUNKS_X || y < 0 || y >= World::CHUNKS_Y) {
+        continue;
+      }
+      if (!World::InRange(chunk, center, ACTIVE_CHUNKS)) {
+        World::Prefetch(chunk);
+      } else if (!World::IsResident(chunk)) {
+        s_spawns.clear();
+        World::Take(chunk, s_spawns);
+        for (const auto &record : s_spawns) {
+          SpawnMeteor(record);
+        }
+        s_residentChunks.push_back(chunk);
+      }
+    }
   }
+}
 
-  s_frame = (s_frame + 1) % FRAME_MAX_COUNTER;
+// SYSTEMS, the parts of a step besides the Registry's own
+
+static void ResetSpaceshipSystem() {
+  PROFILE_SCOPE("ResetSpaceshipSystem");
+  // A life was lost last step
+  if (s_shipLost) {
+    s_shipLost = false;
+    s_Registry->Remove<ColliderComponent>(s_spaceShip);
+  }
 
   // Reset spaceship in case collider was removed
   if (!s_Registry->Get<ColliderComponent>(s_spaceShip)) {
     auto health = s_Registry->Get<HealthComponent>(s_spaceShip);
     Game::ResetSpaceship();
     health->value = g_Game.health;
-    s_Registry->Add<ColliderComponent>(s_spaceShip, SPACESHIP_SIZE.x, SPACESHIP_SIZE.y);
+    s_Registry->Add<ColliderComponent>(s_spaceShip, SPACESHIP_SIZE.x, SPACESHIP_SIZE.y,
+                                       CollisionLayer::SHIP, CollisionLayer::SHIP_MASK);
   }
+}
 
-  // Position + Collision
-  s_Registry->PositionSystem();
-  s_Registry->CollisionDetectionSystem();
-
-  // Particles after Input + Collision (Not sure if this is ok???)
-  // We may have particle generation from weapons, collisions, but what about positioning
-  s_Registry->ParticleSystem();
+// Backdrop follows the ship's push, which is its step (no velocity)
+static void BackdropSystem() {
+  const auto push = s_Registry->Get<ForceComponent>(s_spaceShip);
+  Background::Scroll({BACKGROUND_DRIFT.x + push->value.x * BACKGROUND_PARALLAX,
+                      BACKGROUND_DRIFT.y + push->value.y * BACKGROUND_PARALLAX});
+}
 
-  // SCORE SYSTEM
+static void ScoreSystem() {
+  PROFILE_SCOPE("ScoreSystem");
   // CORES
   auto cores_count = s_Registry->Get<GameStateComponent>(s_coresCount);
   for (const auto &core : s_cores) {
@@ -235,7 +251,7 @@ void UpdateGame(float delta) {
     }
   }
   auto coresCount_text = s_Registry->Get<TextComponent>(s_coresCount);
-  coresCount_text->value = fmt::format("{} Cores", g_Game.total_cores);
+  SetText(coresCount_text, "{} Cores", g_Game.total_cores);
 
   // SCORE
   auto score = s_Registry->Get<GameStateComponent>(s_score);
@@ -248,12 +264,11 @@ void UpdateGame(float delta) {
     }
   }
   auto score_text = s_Registry->Get<TextComponent>(s_score);
-  std::visit([score_text](auto &&value) { score_text->value = fmt::format("{}", value); },
-             score->value);
-
-  // Collision Resolution
-  s_Registry->CollisionResolutionSystem();
+  std::visit([score_text](auto &&value) { SetText(score_text, "{}", value); }, score->value);
+}
 
+static void MeteorSystem() {
+  PROFILE_SCOPE("MeteorSystem");
   // Kill s_cores with zero health
   for (auto core_it = s_cores.begin(); core_it != s_cores.end();) {
     const auto core_health = s_Registry->Get<HealthComponent>(*core_it);
@@ -293,7 +308,8 @@ void UpdateGame(float delta) {
           core_pos->value.x += 10.f;
           core_pos->value.y += 10.f;
         }
-        s_Registry->Add<ColliderComponent>(core, Game::METEOR_CORE_SIZE);
+        s_Registry->Add<ColliderComponent>(core, Game::METEOR_CORE_SIZE, CollisionLayer::CORE,
+                                           CollisionLayer::CORE_MASK);
 
         // Update render so that it is displayed
         auto render = s_Registry->Get<RenderComponent>(core);
@@ -302,6 +318,17 @@ void UpdateGame(float delta) {
       continue;
     }
 
+    // Hidden core travels inside its meteor, which may have bounced
+    const Entity core = *it - 1;
+    if (!s_Registry->Get<ColliderComponent>(core)) {
+      auto core_pos = s_Registry->Get<PositionComponent>(core);
+      auto core_velocity = s_Registry->Get<VelocityComponent>(core);
+      if (core_pos && core_velocity) {
+        core_pos->value = s_Registry->Get<PositionComponent>(*it)->value;
+        core_velocity->value = s_Registry->Get<VelocityComponent>(*it)->value;
+      }
+    }
+
     // Update collider + size based on health
     auto render = s_Registry->Get<RenderComponent>(*it);
     render->dimensions.x = meteor_health->value;
@@ -310,31 +337,292 @@ void UpdateGame(float delta) {
 
     ++it;
   }
+}
 
-  // UISystem-UPDATE ????
-  // Sync state with components i.e Spaceship.health -> SpaceShipHealth.state
+// UISystem-UPDATE ????
+// Sync state with components i.e Spaceship.health -> SpaceShipHealth.state
+static void SpaceshipStateSystem() {
+  PROFILE_SCOPE("SpaceshipStateSystem");
   const auto health = s_Registry->Get<HealthComponent>(s_spaceShip);
   auto state = s_Registry->Get<GameStateComponent>(s_spaceshipHealth);
   std::visit([health](auto &value) { Game::DmgSpaceship(value - health->value); }, state->value);
   state->value = g_Game.health;
 
   auto text = s_Registry->Get<TextComponent>(s_spaceshipLives);
-  text->value = fmt::format("{} Lives", g_Game.lives);
+  SetText(text, "{} Lives", g_Game.lives);
 
   auto spaceship_lives = s_Registry->Get<GameStateComponent>(s_spaceshipLives);
   std::visit(
       [](auto &&value) {
         if (g_Game.lives != value) {
-          // remove collider so that on next cycle we will reset spaceship
-          s_Registry->Remove<ColliderComponent>(s_spaceShip);
+          // the collider goes on the next step, which then resets the spaceship
+          s_shipLost = true;
         }
       },
       spaceship_lives->value);
   spaceship_lives->value = g_Game.lives;
 }
 
+// The order of a step. Systems only wait for the earlier ones they conflict with: particles age
+// during collision detection and the score, the backdrop scrolls during PositionSystem.
+static void BuildSchedule() {
+  using namespace ECS::Resource;
+  auto &registry = *s_Registry;
+  s_schedule = std::make_unique<ECS::Schedule>(registry);
+  auto &schedule = *s_schedule;
+
+  // Input, only when in FOCUS
+  s_inputSystem = schedule.Add("Input", INPUTS, FORCES | WEAPONS | COLLIDERS | RENDERS | ENTITIES,
+                               [&registry] { registry.InputSystem(); });
+  schedule.Add("ResetSpaceship", 0, COLLIDERS | HEALTHS | ENTITIES | GAME, ResetSpaceshipSystem);
+
+  // Position + Collision
+  schedule.Add("Position", FORCES | WEAPONS | SPRITES, POSITIONS | VELOCITIES,
+               [&registry] { registry.PositionSystem(); });
+  schedule.Add("Backdrop", FORCES, BACKDROP, BackdropSystem);
+  schedule.Add("StreamChunks", POSITIONS | VELOCITIES | HEALTHS | RENDERS | COLLIDERS,
+               ENTITIES | GAME, StreamChunks);
+  schedule.Add("ParticleCleanup", PARTICLES, ENTITIES,
+               [&registry] { registry.ParticleCleanupSystem(); });
+  schedule.Add("CollisionDetection", POSITIONS | RENDERS | BODIES, COLLIDERS | CONTACTS,
+               [&registry] { registry.CollisionDetectionSystem(); });
+
+  // Particles after Input + Collision (Not sure if this is ok???)
+  // We may have particle generation from weapons, collisions, but what about positioning
+  schedule.Add("Particles", POSITIONS, EMITTERS | PARTICLES | HEALTHS,
+               [&registry] { registry.ParticleSystem(); });
+
+  schedule.Add("Score", COLLIDERS, STATE_VALUES | TEXTS | GAME, ScoreSystem);
+  schedule.Add("CollisionResolution", DMGS | CONTACTS,
+               POSITIONS | VELOCITIES | COLLIDERS | BODIES | HEALTHS | RENDERS | PARTICLES |
+                   RANDOM | ENTITIES,
+               [&registry] { registry.CollisionResolutionSystem(); });
+  schedule.Add("Meteors", 0,
+               POSITIONS | VELOCITIES | COLLIDERS | RENDERS | HEALTHS | ENTITIES | GAME,
+               MeteorSystem);
+  schedule.Add("SpaceshipState", HEALTHS, STATE_VALUES | TEXTS | GAME, SpaceshipStateSystem);
+}
+
+void LoadGame() {
+  PROFILE_SCOPE("LoadGame");
+  auto &platform = Platform::Get();
+  float screen_cw = platform.GetScreenWidth() / 2.f;
+
+  s_Registry = std::make_unique<ECS::Registry>();
+  s_Registry->Init();
+  BuildSchedule();
+
+  // Randomizers
+  auto &rng = Random::Get(Random::METEORS);
+  auto &shapes = Random::Get(Random::SHAPES);
+  MeteorShapes::Generate(static_cast<int>(shapes()));
+  auto &backdrop = Random::Get(Random::BACKGROUND);
+  const uint64_t backdrop_seed = static_cast<uint64_t>(backdrop()) << 32 | backdrop();
+  Background::Generate(backdrop_seed, platform.GetScreenWidth(), platform.GetScreenHeight());
+
+  // World, the ship starts in its middle
+  const Vector2 start{World::SIZE.x / 2.f, World::SIZE.y / 2.f};
+  const auto &meteors = g_Game.meteors;
+  s_Registry->SetWorldSize(World::SIZE);
+  const uint64_t world_seed = static_cast<uint64_t>(rng()) << 32 | rng();
+  const World::Params world{MIN_METEORS_PER_CHUNK,
+                            meteors.max_meteors,
+                            meteors.min_meteor_size,
+                            meteors.max_meteor_size,
+                            meteors.meteor_min_velocity,
+                            meteors.meteor_max_velocity,
+                            {start.x + SPACESHIP_SIZE.x / 2.f, start.y + SPACESHIP_SIZE.y / 2.f},
+                            START_CLEAR_RADIUS};
+  World::Generate(world_seed, world);
+
+  // Our Hero
+  s_spaceShip = s_Registry->CreateEntity();
+  s_Registry->Add<PositionComponent>(s_spaceShip, start.x, start.y);
+  // s_Registry->Add<RenderComponent>(s_spaceShip, Layer::GROUND, Shape::ELLIPSE, BLACK,
+  //                                  SPACESHIP_SIZE.x, SPACESHIP_SIZE.y);
+  s_Registry->Add<SpriteComponent>(s_spaceShip, Layer::GROUND, "ufo.png");
+  s_Registry->Add<ColliderComponent>(s_spaceShip, SPACESHIP_SIZE.x, SPACESHIP_SIZE.y,
+                                     CollisionLayer::SHIP, CollisionLayer::SHIP_MASK);
+  s_Registry->Add<DmgComponent>(s_spaceShip, 0.1f);
+  s_Registry->Add<HealthComponent>(s_spaceShip, g_Game.health);
+  s_Registry->Add<ForceComponent>(s_spaceShip, 0.f, 0.f); // Initialize empty force
+  s_Registry->Add<ECS::InputComponent>(s_spaceShip, PUSH_FORCE_STEP, MAX_PUSH_FORCE);
+
+  // Spaceship's Mining Beam
+  s_miningBeam = s_Registry->CreateEntity();
+  s_Registry->Add<PositionComponent>(s_miningBeam, 0.f, 0.f);
+  s_Registry->Add<WeaponComponent>(s_miningBeam, s_spaceShip, Game::WEAPON_MAX_DISTANCE);
+  s_Registry->Add<DmgComponent>(s_miningBeam, Game::WEAPON_DMG);
+  // s_Registry->Add<EmitterComponent>(s_miningBeam, 15 /* emmission rate */,
+  //                                   50 /* particle lifetime */, Shape::LINE,
+  //                                   Vector2{0.f, 1.f} /* particle velocity */);
+
+  // Meteors around the ship, the rest streams in as it moves
+  s_meteors.clear();
+  s_cores.clear();
+  s_residentChunks.clear();
+  // Streaming keeps every kept chunk's records at most, each a meteor and its core: room for
+  // them now, so crossing into a chunk does not allocate
+  const size_t resident = KEPT_CHUNKS * World::RecordCapacity(world);
+  s_meteors.reserve(resident);
+  s_cores.reserve(resident);
+  s_residentChunks.reserve(KEPT_CHUNKS);
+  s_spawns.reserve(World::RecordCapacity(world));
+  s_Registry->Reserve<PositionComponent, VelocityComponent, HealthComponent, RenderComponent,
+                      ColliderComponent>(2 * resident);
+  s_Registry->Reserve<BodyComponent, DmgComponent>(resident);
+  StreamChunks();
+
+  // State: Spaceship health (UI Entity)
+  s_spaceshipHealth = s_Registry->CreateEntity();
+  s_Registry->Add<GameStateComponent>(s_spaceshipHealth, g_Game.health);
+  s_Registry->Add<UIComponent>(s_spaceshipHealth, UIElement::BAR, DARKGREEN);
+  s_Registry->Add<PositionComponent>(s_spaceshipHealth, 10.f, 10.f);
+
+  // Spaceship Lives (UI Entity)
+  s_spaceshipLives = s_Registry->CreateEntity();
+  s_Registry->Add<GameStateComponent>(s_spaceshipLives, g_Game.lives);
+  s_Registry->Add<TextComponent>(s_spaceshipLives, fmt::format("{} Lives", g_Game.lives), MAROON);
+  s_Registry->Add<PositionComponent>(
+      s_spaceshipLives, platform.GetScreenWidth() - platform.MeasureText(" Lives", 20) - 20.f,
+      10.f);
+
+  // Fuel (UI Entity)
+  // s_spaceshipFuel = s_Registry->CreateEntity();
+  // s_Registry->Add<GameStateComponent>(s_spaceshipFuel, g_Game.fuel);
+  // s_Registry->Add<UIComponent>(s_spaceshipFuel, UIElement::BAR, BLACK);
+  // s_Registry->Add<PositionComponent>(s_spaceshipFuel, 10.f, 30.f);
+
+  // Scores (UI Entity)
+  s_score = s_Registry->CreateEntity();
+  s_Registry->Add<GameStateComponent>(s_score, g_Game.score);
+  s_Registry->Add<TextComponent>(s_score, fmt::format("{}", g_Game.score), BROWN);
+  s_Registry->Add<PositionComponent>(s_score, screen_cw - 10.f, 10.f);
+
+  // # Cores (UI Entity)
+  s_coresCount = s_Registry->CreateEntity();
+  s_Registry->Add<GameStateComponent>(s_coresCount, g_Game.total_cores);
+  s_Registry->Add<TextComponent>(s_coresCount, fmt::format("{} Cores", g_Game.total_cores),
+                                 DARKGREEN);
+  s_Registry->Add<PositionComponent>(s_coresCount, screen_cw * 1.5f, 10.f);
+
+  // Level (UI Entity)
+  s_level = s_Registry->CreateEntity();
+  s_Registry->Add<GameStateComponent>(s_level, g_Game.level);
+  s_Registry->Add<TextComponent>(s_level, fmt::format("L {}", g_Game.level), DARKBLUE);
+  s_Registry->Add<PositionComponent>(s_level, 140.f, 10.f);
+
+  s_state = GameState::PLAY;
+  s_shipLost = false;
+  s_IsFocused = true;
+
+  // Drawn until the first simulation builds one
+  s_screen = {static_cast<float>(platform.GetScreenWidth()),
+              static_cast<float>(platform.GetScreenHeight())};
+  BuildGameFrame(1.f);
+  SwapGameFrame();
+}
+
+void UpdateGame(float delta) {
+  PROFILE_SCOPE("UpdateGame");
+  // check if round is won or lost
+  if (Game::IsGameWon()) {
+    s_state = GameState::WON;
+    s_Event = SceneEvent::NEXT;
+    return;
+  } else if (Game::IsGameLost()) {
+    s_state = GameState::LOST;
+    s_Event = SceneEvent::NEXT;
+    return;
+  }
+
+  // HANDLE INPUT only when in FOCUS
+  if (s_IsFocused && Platform::Get().IsKeyPressed(KEY_ESCAPE)) {
+    s_state = GameState::PAUSE;
+    s_Event = SceneEvent::PAUSE;
+  }
+
+  if (Platform::Get().IsKeyPressed(KEY_F2)) {
+    s_inspector = !s_inspector;
+  }
+
+  // For this frame's steps, which may run on a worker
+  if (s_IsFocused) {
+    s_Registry->SampleInput();
+  }
+}
+
+// One fixed simulation tick, all per-tick constants (velocities, forces, lifetimes) assume it
+void StepGame(float step) {
+  PROFILE_SCOPE("StepGame");
+  if (GameState::PLAY != s_state || SceneEvent::NONE != s_Event) {
+    return;
+  }
+
+  // Handle Fuel consumption
+  // if (IsKeyDown(KEY_RIGHT) || IsKeyDown(KEY_LEFT) || IsKeyDown(KEY_UP) || IsKeyDown(KEY_DOWN)) {
+  //   Game::LoseFuel();
+  //   auto fuel = s_Registry->Get<GameStateComponent>(s_spaceshipFuel);
+  //   fuel->value = g_Game.fuel;
+  // }
+
+  s_frame = (s_frame + 1) % FRAME_MAX_COUNTER;
+
+  s_schedule->SetEnabled(s_inputSystem, s_IsFocused);
+  s_schedule->Run();
+}
+
+void BuildGameFrame(float alpha) {
+  PROFILE_SCOPE("BuildGameFrame");
+  s_Registry->SetInterpolation(alpha);
+  auto &frame = s_frames[1 - s_drawn];
+  frame.list.Clear();
+  frame.backdrop = Background::Offset();
+  frame.alpha = alpha;
+  s_Registry->UISystem(frame.list);
+
+  // Camera follows the ship and stops at the edges of the world
+  const Vector2 half{s_screen.x / 2.f, s_screen.y / 2.f};
+  const Vector2 ship = s_Registry->RenderPosition(s_spaceShip);
+  const Vector2 target{
+      std::clamp(ship.x + SPACESHIP_SIZE.x / 2.f, half.x, World::SIZE.x - half.x),
+      std::clamp(ship.y + SPACESHIP_SIZE.y / 2.f, half.y, World::SIZE.y - half.y)};
+  frame.camera = {half, target, 0.f, 1.f};
+  s_Registry->SetCamera(frame.camera);
+  s_Registry->RenderSystem(frame.list, s_screen);
+  s_Registry->CaptureSnapshots();
+}
+
+void SwapGameFrame() {
+  s_drawn = 1 - s_drawn;
+  s_Registry->SwapSnapshots();
+}
+
+// Runs during the next simulation: only the snapshots of the registry are read
+static void DrawInspector(const Frame &frame) {
+  PROFILE_SCOPE("DrawInspector");
+  auto &platform = Platform::Get();
+  const auto &positions = s_Registry->Snapshot<PositionComponent>();
+  const auto &renders = s_Registry->Snapshot<RenderComponent>();
+  platform.BeginMode2D(frame.camera);
+  for (const auto &health : s_Registry->Snapshot<HealthComponent>().Records()) {
+    const auto render = renders.Get(health.entity);
+    const auto pos = positions.Get(health.entity);
+    if (!render || !pos || render->dimensions.x <= 0.f ||
+        (Shape::METEOR != render->shape && Shape::CIRCLE != render->shape)) {
+      continue; // particles, hidden cores
+    }
+    const Vector2 at = Vector2Lerp(pos->previous, pos->value, frame.alpha);
+    platform.DrawText(TextFormat("%zu: %.0f", health.entity, health.value), at.x,
+                      at.y + render->dimensions.x, 10, RED);
+  }
+  platform.EndMode2D();
+}
+
 void DrawGame() {
-  s_Registry->UISystem();
+  PROFILE_SCOPE("DrawGame");
+  const auto &frame = s_frames[s_drawn];
+  Background::Draw(frame.backdrop);
 
   // TEST PLANETS
   // DrawCircleLinesV({300.f, 300.f}, 80.f, BLACK);
@@ -344,7 +632,10 @@ void DrawGame() {
 
   // DrawLineStrip(shipPoints.data(), shipPoints.size(), BLACK);
 
-  s_Registry->RenderSystem();
+  frame.list.Submit();
+  if (s_inspector) {
+    DrawInspector(frame);
+  }
 
   // if (GameState::PLAY != s_state) {
   //   // TODO: implement menu/overlay handling
@@ -375,29 +666,6 @@ void DrawGame() {
   // BLACK); DrawRectangle(15.f, 15.f, GetScreenWidth() - 30.f, GetScreenHeight() - 30.f,
   // RED);
 
-  // Render Meteors info for DEBUG
-  // for (const auto &meteor : s_meteors) {
-  //   const auto &health = s_Registry->Get<HealthComponent>(meteor);
-  //   const auto &pos = s_Registry->Get<PositionComponent>(meteor);
-  //   const auto &render = s_Registry->Get<s_Registry->RenderComponent>(meteor);
-  //   DrawText(TextFormat("%i", meteor), pos->value.x,
-  //            pos->value.y + render->m_dimensions.x, 20, GREEN);
-  //   // DrawRectangle(pos->value.x + render->m_dimensions.x,
-  //   //               pos->value.y + render->m_dimensions.x, health->value, 10,
-  //   BLACK);
-  // }
-
-  // Render Cores info for DEBUG
-  // for (const auto &core : s_cores) {
-  //   const auto &pos = s_Registry->Get<PositionComponent>(core);
-  //   const auto &render = s_Registry->Get<s_Registry->RenderComponent>(core);
-  //   DrawText(TextFormat("%i", core), pos->value.x,
-  //            pos->value.y + render->m_dimensions.x, 20, RED);
-  //   // DrawRectangle(pos->value.x + render->m_dimensions.x,
-  //   //               pos->value.y + render->m_dimensions.x, health->value, 10,
-  //   BLACK);
-  // }
-
   // DEBUG
   // const auto &collider = s_Registry->Get<ColliderComponent>(s_miningBeam);
   // if (collider) {
@@ -416,14 +684,24 @@ void DrawGame() {
 void UnloadGame() {
   s_meteors.clear();
   s_cores.clear();
+  s_residentChunks.clear();
   s_Event = SceneEvent::NONE;
+  for (auto &frame : s_frames) {
+    frame.list.Clear(); // its sprites' textures go with the registry
+  }
+  s_schedule.reset();
   s_Registry.reset();
+  Background::Unload();
+  World::Shutdown();
 }
 
 void SetGameFocus(bool focus) {
   if (focus) {
     s_state = GameState::PLAY;
     s_Event = SceneEvent::NONE;
+  } else {
+    // No step runs while paused: time to give back what particle bursts left in the pools
+    s_Registry->ShrinkToFit();
   }
   s_IsFocused = focus;
 }
@@ -15,16 +15,17 @@ using ECS::PositionComponent, ECS::SpriteComponent, ECS::Layer, ECS::Entity;
 void LoadIntro() {
   s_Registry = std::make_unique<ECS::Registry>();
 
-  float posX = (float)GetScreenWidth() / 2.f - 218.f;
-  float posY = (float)GetScreenHeight() / 2.f - 46.f;
+  float posX = (float)Platform::Get().GetScreenWidth() / 2.f - 218.f;
+  float posY = (float)Platform::Get().GetScreenHeight() / 2.f - 46.f;
   auto title = s_Registry->CreateEntity();
   s_Registry->Add<SpriteComponent>(title, Layer::SKY, "minoids_logo.png");
   s_Registry->Add<PositionComponent>(title, posX, posY);
 }
 
 void UpdateIntro(float delta) {
-  if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON) || IsKeyPressed(KEY_SPACE) ||
-      IsKeyPressed(KEY_ENTER)) {
+  auto &platform = Platform::Get();
+  if (platform.IsMouseButtonPressed(MOUSE_LEFT_BUTTON) || platform.IsKeyPressed(KEY_SPACE) ||
+      platform.IsKeyPressed(KEY_ENTER)) {
     s_Event = SceneEvent::PAUSE;
     return;
   }
@@ -22,12 +22,12 @@ static ECS::Entity s_SelectedBtn;
 
 // Get PosX of Horizontally Screen centered text
 static float H_CenterText(const std::string_view &text) {
-  return (GetScreenWidth() - MeasureText(text.data(), 20)) / 2.f;
+  return (Platform::Get().GetScreenWidth() - Platform::Get().MeasureText(text.data(), 20)) / 2.f;
 }
 
 void LoadMenu(std::vector<ButtonConfig> &&config) {
-  float screen_cw = GetScreenWidth() / 2.f;
-  float screen_ch = GetScreenHeight() / 2.f;
+  float screen_cw = Platform::Get().GetScreenWidth() / 2.f;
+  float screen_ch = Platform::Get().GetScreenHeight() / 2.f;
 
   s_buttonConfigs = std::move(config);
 
@@ -72,17 +72,19 @@ void LoadMenu(std::vector<ButtonConfig> &&config) {
 }
 
 void UpdateMenu(float delta) {
+  auto &platform = Platform::Get();
+
   s_Registry->PositionSystem();
 
   // Handle UI here ... for now
   int mod = 0;
-  if (IsKeyPressed(KEY_ESCAPE)) {
+  if (platform.IsKeyPressed(KEY_ESCAPE)) {
     s_Event = SceneEvent::CONTINUE;
-  } else if (IsKeyPressed(KEY_DOWN)) {
+  } else if (platform.IsKeyPressed(KEY_DOWN)) {
     mod = 1;
-  } else if (IsKeyPressed(KEY_UP)) {
+  } else if (platform.IsKeyPressed(KEY_UP)) {
     mod = -1;
-  } else if (IsKeyPressed(KEY_ENTER)) {
+  } else if (platform.IsKeyPressed(KEY_ENTER)) {
     s_Event = s_buttonConfigs[s_State.selected].second;
     return;
   }
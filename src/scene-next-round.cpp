@@ -33,9 +33,9 @@ Entity s_coresCount;
 void LoadNextRound() {
   s_Registry = std::make_unique<ECS::Registry>();
 
-  float centerX = (float)GetScreenWidth() / 2.f;
-  float centerY = (float)GetScreenHeight() / 2.f;
-  float screenX_1_4 = (float)GetScreenWidth() / 4.f;
+  float centerX = (float)Platform::Get().GetScreenWidth() / 2.f;
+  float centerY = (float)Platform::Get().GetScreenHeight() / 2.f;
+  float screenX_1_4 = (float)Platform::Get().GetScreenWidth() / 4.f;
 
   // SHOP
   float posX = screenX_1_4 - cardW / 2.f;
@@ -146,9 +146,11 @@ void LoadNextRound() {
 }
 
 void UpdateNextRound(float delta) {
-  if (IsKeyPressed(KEY_LEFT)) {
+  auto &platform = Platform::Get();
+
+  if (platform.IsKeyPressed(KEY_LEFT)) {
     --selected;
-  } else if (IsKeyPressed(KEY_RIGHT)) {
+  } else if (platform.IsKeyPressed(KEY_RIGHT)) {
     ++selected;
   }
 
@@ -158,7 +160,8 @@ void UpdateNextRound(float delta) {
     selected = 1;
   }
 
-  if ((IsKeyPressed(KEY_SPACE) || IsKeyPressed(KEY_ENTER)) && Game::Buy(selected)) {
+  if ((platform.IsKeyPressed(KEY_SPACE) || platform.IsKeyPressed(KEY_ENTER)) &&
+      Game::Buy(selected)) {
     if (Game::IsGameWon()) {
       Game::NextLevel();
     } else {
@@ -172,7 +175,7 @@ void UpdateNextRound(float delta) {
 }
 
 void DrawNextRound() {
-  float screenX_1_4 = (float)GetScreenWidth() / 4.f;
+  float screenX_1_4 = (float)Platform::Get().GetScreenWidth() / 4.f;
 
   auto posBottom = s_Registry->Get<PositionComponent>(s_selectionBottom);
   posBottom->value.x = (float)selected * screenX_1_4 - cardW / 2.f + SELECTED_CARD_OFFSET;
@@ -42,6 +42,11 @@ bool IsMenuUnloaded();
 
 void LoadGame();
 void UpdateGame(float delta);
+void StepGame(float step);
+// Records the state `alpha` of a step past the previous one, see SimulateCurrentScene
+void BuildGameFrame(float alpha);
+// The frame just built is the one DrawGame draws, main thread once the simulation is done
+void SwapGameFrame();
 void DrawGame();
 void UnloadGame();
 SceneEvent OnGameEvent();
@@ -4,6 +4,7 @@
 #include <algorithm>
 #include <climits>
 #include <cstddef>
+#include <iterator>
 #include <utility>
 #include <vector>
 
@@ -11,6 +12,18 @@
 static constexpr int INITIAL_ELEMENTS = 5000;
 static constexpr size_t EMPTY = ULLONG_MAX - 1;
 
+// Memory held by one pool. Bytes count the set's own arrays, not what components own on the
+// heap (strings, noise values).
+struct PoolStats {
+  size_t live;          // components
+  size_t capacity;      // components the dense array holds without growing
+  size_t high_water;    // most live components since construction or the last ShrinkToFit
+  size_t sparse_length; // highest entity id + 1 the set can index
+  size_t live_bytes;
+  size_t capacity_bytes; // dense capacity + sparse capacity
+  size_t high_water_bytes;
+};
+
 template <typename T> class SparseSet {
 public:
   std::vector<size_t> sparse;
@@ -34,12 +47,15 @@ public:
   }
 
   // TODO: reuse and/or update
-  // TODO: handle resize
   bool Add(size_t id, T &&denseItem) {
+    if (id >= sparse.size()) {
+      sparse.resize(std::max(id + 1, sparse.size() * 2), EMPTY);
+    }
     if (!contains(id)) {
       denseItem.entity = id;
       sparse.at(id) = dense.size();
       dense.push_back(std::move(denseItem));
+      m_high_water = std::max(m_high_water, dense.size());
       return true;
     }
     return false;
@@ -72,6 +88,47 @@ public:
     dense.clear();
     // size = 0;
   }
+
+  PoolStats Stats() const {
+    return {dense.size(),
+            dense.capacity(),
+            m_high_water,
+            sparse.size(),
+            dense.size() * sizeof(T),
+            dense.capacity() * sizeof(T) + sparse.capacity() * sizeof(size_t),
+            m_high_water * sizeof(T)};
+  }
+
+  // Room for `count` components without growing, which ShrinkToFit keeps
+  void Reserve(size_t count) {
+    dense.reserve(count);
+    m_reserved = std::max(m_reserved, count);
+  }
+
+  // Gives back what a burst left behind: dense capacity above the live count and the sparse
+  // tail past the highest live id, both kept at least `keep` long (and the dense array its
+  // reservation). Reallocates, so call it between frames, not every frame.
+  void ShrinkToFit(size_t keep = 0) {
+    size_t length = sparse.size();
+    while (length > keep && sparse[length - 1] == EMPTY) {
+      --length;
+    }
+    sparse.resize(length);
+    sparse.shrink_to_fit();
+
+    const size_t capacity = std::max({dense.size(), keep, m_reserved});
+    if (dense.capacity() > capacity) {
+      std::vector<T> trimmed;
+      trimmed.reserve(capacity);
+      std::move(dense.begin(), dense.end(), std::back_inserter(trimmed));
+      dense.swap(trimmed);
+    }
+    m_high_water = dense.size();
+  }
+
+private:
+  size_t m_high_water = 0;
+  size_t m_reserved = 0;
 };
 
 #endif
@@ -0,0 +1,155 @@
+#include "system-schedule.hpp"
+#include "profiler.hpp"
+#include <cassert>
+#include <cstdio>
+#include <iterator>
+
+namespace ECS {
+
+bool Schedule::Conflict(const Entry &a, const Entry &b) {
+  if ((a.writes | b.writes) & Resource::ENTITIES) {
+    return true;
+  }
+  return (a.writes & (b.reads | b.writes)) || (b.writes & (a.reads | a.writes));
+}
+
+Schedule::System Schedule::Add(const char *name, Access reads, Access writes,
+                               std::function<void()> run) {
+  assert(m_systems.size() < MAX_SYSTEMS);
+  m_systems.push_back({name, reads, writes, std::move(run), true, 0});
+  return m_systems.size() - 1;
+}
+
+void Schedule::Run() {
+  PROFILE_SCOPE("Schedule::Run");
+#ifdef MINOIDS_CHECK_ACCESS
+  RunChecked();
+#else
+  // Every system waits for the earlier enabled ones it conflicts with, so the step gives what
+  // running them in order would
+  const size_t count = m_systems.size();
+  uint64_t roots = 0;
+  for (size_t i = 0; i < count; i++) {
+    m_dependents[i] = 0;
+    int waiting = 0;
+    for (size_t j = 0; j < i; j++) {
+      if (m_systems[i].enabled && m_systems[j].enabled && Conflict(m_systems[j], m_systems[i])) {
+        m_dependents[j] |= uint64_t{1} << i;
+        waiting++;
+      }
+    }
+    m_waiting[i].store(waiting, std::memory_order_relaxed);
+    if (m_systems[i].enabled && waiting == 0) {
+      roots |= uint64_t{1} << i;
+    }
+  }
+
+  // Known before the first launch: a root done meanwhile brings others' counts to zero too, and
+  // launches them itself
+  for (System system = 0; system < count; system++) {
+    if (roots >> system & 1) {
+      Launch(system);
+    }
+  }
+  Jobs::Wait(m_done);
+#endif
+}
+
+void Schedule::Launch(System system) {
+  const Entry &entry = m_systems[system];
+  const bool platform = (entry.reads | entry.writes) & Resource::PLATFORM;
+  Jobs::Run([this, system] { Execute(system); }, &m_done, nullptr,
+            platform ? Jobs::MAIN_THREAD : Jobs::ANY);
+}
+
+// Runs `system` then starts the systems that were only waiting for it. They are counted on
+// m_done before this job finishes, so Run cannot return in between.
+void Schedule::Execute(System system) {
+  m_systems[system].run();
+  const uint64_t dependents = m_dependents[system];
+  for (System next = system + 1; next < m_systems.size(); next++) {
+    if (!(dependents >> next & 1)) {
+      continue;
+    }
+    if (m_waiting[next].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      Launch(next);
+    }
+  }
+}
+
+// ACCESS CHECK
+
+// Pools in Resource order, then the other resources
+static const char *const RESOURCE_NAMES[] = {
+    "positions", "velocities", "colliders", "texts",  "forces",      "renders",
+    "sprites",   "widgets",    "healths",   "dmgs",   "stateValues", "weapons",
+    "inputs",    "emitters",   "particles", "bodies", "entities",    "contacts",
+    "platform",  "random"};
+
+static thread_local const char *t_system = nullptr;
+static thread_local Access t_reads = 0;
+static thread_local Access t_writes = 0;
+static thread_local Access *t_reported = nullptr;
+
+static void Report(const char *system, const char *verb, Access missing, Access &reported) {
+  missing &= ~reported;
+  reported |= missing;
+  for (int bit = 0; missing; bit++, missing >>= 1) {
+    if (missing & 1) {
+      if (bit < static_cast<int>(std::size(RESOURCE_NAMES))) {
+        std::fprintf(stderr, "System %s %s %s without declaring it\n", system, verb,
+                     RESOURCE_NAMES[bit]);
+      } else {
+        std::fprintf(stderr, "System %s %s resource bit %d without declaring it\n", system, verb,
+                     bit);
+      }
+    }
+  }
+}
+
+#ifdef MINOIDS_CHECK_ACCESS
+void CheckAccess(Access resources, bool write) {
+  if (!t_system) {
+    return;
+  }
+  const Access declared = write ? t_writes : t_reads | t_writes;
+  if (resources & ~declared) {
+    Report(t_system, write ? "writes" : "reads", resources & ~declared, *t_reported);
+  }
+}
+#endif
+
+// In order on this thread: another system running meanwhile would change the hashes
+void Schedule::RunChecked() {
+  uint64_t before[Resource::POOL_COUNT];
+  uint64_t after[Resource::POOL_COUNT];
+  for (auto &entry : m_systems) {
+    if (!entry.enabled) {
+      continue;
+    }
+    m_registry.PoolChecksums(before);
+    t_system = entry.name;
+    t_reads = entry.reads;
+    t_writes = entry.writes;
+    t_reported = &entry.reported;
+    entry.run();
+    t_system = nullptr;
+
+    // Entity changes touch any pool, they are checked by CheckAccess instead
+    if (entry.writes & Resource::ENTITIES) {
+      continue;
+    }
+    m_registry.PoolChecksums(after);
+    Access changed = 0;
+    for (int pool = 0; pool < Resource::POOL_COUNT; pool++) {
+      if (before[pool] != after[pool]) {
+        changed |= Access{1} << pool;
+      }
+    }
+    if (changed & ~entry.writes) {
+      Report(entry.name, "writes", changed & ~entry.writes, entry.reported);
+    }
+  }
+}
+
+} // namespace ECS
@@ -0,0 +1,74 @@
+#ifndef SYSTEM_SCHEDULE_H
+#define SYSTEM_SCHEDULE_H
+
+// The systems of a step with what they read and write. Run gives the same result as calling them
+// one after the other in the order they were added, but starts each one on a worker (see
+// jobs.hpp) as soon as the earlier systems it conflicts with are done. Two systems conflict when
+// one writes what the other reads or writes; writing ENTITIES conflicts with everything.
+//
+//   using namespace ECS::Resource;
+//   ECS::Schedule schedule(registry);
+//   schedule.Add("Position", FORCES, POSITIONS | VELOCITIES, [&] { registry.PositionSystem(); });
+//   schedule.Add("Particles", POSITIONS, HEALTHS | PARTICLES, [&] { registry.ParticleSystem(); });
+//   schedule.Run(); // every step
+//
+// Systems touching PLATFORM run on the main thread. Built with MINOIDS_CHECK_ACCESS, Run calls
+// the systems one at a time in order and reports, once per system and resource, reads through
+// Registry::Get, entity changes and pool changes its declaration does not cover. Pools the
+// Registry's own systems read directly are not seen.
+
+#include "ecs.hpp"
+#include "jobs.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace ECS {
+
+class Schedule {
+public:
+  using System = size_t;
+  static constexpr size_t MAX_SYSTEMS = 64;
+
+  explicit Schedule(Registry &registry) : m_registry(registry) {}
+  Schedule(const Schedule &) = delete;
+  Schedule &operator=(const Schedule &) = delete;
+
+  // Writing a resource implies reading it
+  System Add(const char *name, Access reads, Access writes, std::function<void()> run);
+
+  // Disabled systems are left out of the graph until enabled again
+  void SetEnabled(System system, bool enabled) { m_systems[system].enabled = enabled; }
+
+  // Builds this step's graph and returns once every enabled system ran
+  void Run();
+
+private:
+  struct Entry {
+    const char *name;
+    Access reads;
+    Access writes;
+    std::function<void()> run;
+    bool enabled;
+    Access reported; // MINOIDS_CHECK_ACCESS: undeclared resources already reported
+  };
+
+  static bool Conflict(const Entry &a, const Entry &b);
+  void Launch(System system);
+  void Execute(System system);
+  void RunChecked();
+
+  Registry &m_registry;
+  std::vector<Entry> m_systems;
+
+  // Graph of the running step
+  uint64_t m_dependents[MAX_SYSTEMS]; // bit per later system waiting for this one
+  std::atomic<int> m_waiting[MAX_SYSTEMS];
+  Jobs::Counter m_done;
+};
+
+} // namespace ECS
+
+#endif
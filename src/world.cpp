@@ -0,0 +1,187 @@
+#include "world.hpp"
+#include "FastNoiseLite.h"
+#include "jobs.hpp"
+#include "profiler.hpp"
+#include "random.hpp"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace World {
+
+static constexpr int CHUNK_COUNT = CHUNKS_X * CHUNKS_Y;
+
+// Fields: low frequency fractal noise, sampled per cell of a chunk
+static constexpr float FIELD_FREQUENCY = 1.f / 1500.f;
+static constexpr int FIELD_CELLS = 8; // per chunk side
+static constexpr float FIELD_CELL_SIZE = CHUNK_SIZE / FIELD_CELLS;
+static constexpr int PLACEMENT_TRIES = 8; // per meteor, rejected where the field is thin
+
+enum class State : uint8_t { EMPTY, PENDING, READY, RESIDENT };
+
+struct ChunkState {
+  State state = State::EMPTY;
+  std::vector<Meteor> meteors; // records, whatever the state
+  Jobs::Counter generating;
+  std::vector<Meteor> field; // written by the generation job, PENDING only
+};
+static ChunkState s_chunks[CHUNK_COUNT];
+
+// Read by the generation jobs, only changed once none is running
+static uint64_t s_seed = 0;
+static Params s_params{};
+
+static int Index(Chunk chunk) { return chunk.y * CHUNKS_X + chunk.x; }
+
+static void GenerateField(uint64_t seed, const Params &params, int index,
+                          std::vector<Meteor> &out) {
+  PROFILE_SCOPE("World::GenerateField");
+  const float x0 = (index % CHUNKS_X) * CHUNK_SIZE;
+  const float y0 = (index / CHUNKS_X) * CHUNK_SIZE;
+
+  FastNoiseLite field(static_cast<int>(seed));
+  field.SetNoiseType(FastNoiseLite::NoiseType_OpenSimplex2);
+  field.SetFractalType(FastNoiseLite::FractalType_FBm);
+  field.SetFractalOctaves(3);
+  field.SetFrequency(FIELD_FREQUENCY);
+
+  // Density in [0, 1] at the cell centers
+  float density[FIELD_CELLS * FIELD_CELLS];
+  field.GetNoiseGrid(x0 + FIELD_CELL_SIZE / 2.f, y0 + FIELD_CELL_SIZE / 2.f, FIELD_CELL_SIZE,
+                     FIELD_CELLS, FIELD_CELLS, density);
+  float mean = 0.f;
+  for (float &cell : density) {
+    cell = std::clamp(cell + .5f, 0.f, 1.f);
+    mean += cell;
+  }
+  mean /= FIELD_CELLS * FIELD_CELLS;
+
+  // Its own stream: the field does not depend on which chunks were generated before
+  Random::Generator rng(seed ^ static_cast<uint64_t>(index + 1) << 32);
+  const int count = params.min_per_chunk +
+                    static_cast<int>(mean * (params.max_per_chunk - params.min_per_chunk) + .5f);
+  for (int i = 0; i < count; i++) {
+    for (int attempt = 0; attempt < PLACEMENT_TRIES; attempt++) {
+      const float u = rng.Float();
+      const float v = rng.Float();
+      const int cell = static_cast<int>(v * FIELD_CELLS) * FIELD_CELLS +
+                       static_cast<int>(u * FIELD_CELLS);
+      if (rng.Float() >= density[cell]) {
+        continue;
+      }
+
+      const Vector2 position{x0 + u * CHUNK_SIZE, y0 + v * CHUNK_SIZE};
+      const float dx = position.x - params.clear_center.x;
+      const float dy = position.y - params.clear_center.y;
+      if (dx * dx + dy * dy < params.clear_radius * params.clear_radius) {
+        continue;
+      }
+
+      const Vector2 velocity{rng.Float(params.min_velocity, params.max_velocity),
+                             rng.Float(params.min_velocity, params.max_velocity)};
+      const float radius = static_cast<float>(rng.Int(params.min_size, params.max_size));
+      out.push_back({position, velocity, radius, MeteorShapes::Pick(rng)});
+      break;
+    }
+  }
+}
+
+// Generated field first, then the records stored while it was pending. Both keep their buffers.
+static void Complete(ChunkState &chunk) {
+  chunk.meteors.insert(chunk.meteors.begin(), chunk.field.begin(), chunk.field.end());
+  chunk.field.clear();
+  chunk.state = State::READY;
+}
+
+static void WaitForField(ChunkState &chunk) {
+  if (State::PENDING == chunk.state) {
+    PROFILE_SCOPE("World::WaitForField");
+    Jobs::Wait(chunk.generating);
+    Complete(chunk);
+  }
+}
+
+void Generate(uint64_t seed, const Params &params) {
+  Shutdown();
+  s_seed = seed;
+  s_params = params;
+  // Streaming runs in the steps, on a worker: every buffer it fills is reserved here
+  for (auto &chunk : s_chunks) {
+    chunk.state = State::EMPTY;
+    chunk.meteors.clear();
+    chunk.meteors.reserve(RecordCapacity(params));
+    chunk.field.reserve(params.max_per_chunk);
+  }
+}
+
+void Shutdown() {
+  for (auto &chunk : s_chunks) {
+    Jobs::Wait(chunk.generating);
+    if (State::PENDING == chunk.state) {
+      chunk.state = State::EMPTY;
+      chunk.field.clear();
+    }
+  }
+}
+
+Chunk ChunkAt(Vector2 position) {
+  return {std::clamp(static_cast<int>(std::floor(position.x / CHUNK_SIZE)), 0, CHUNKS_X - 1),
+          std::clamp(static_cast<int>(std::floor(position.y / CHUNK_SIZE)), 0, CHUNKS_Y - 1)};
+}
+
+void Prefetch(Chunk chunk) {
+  if (chunk.x < 0 || chunk.x >= CHUNKS_X || chunk.y < 0 || chunk.y >= CHUNKS_Y) {
+    return;
+  }
+  const int index = Index(chunk);
+  if (State::EMPTY != s_chunks[index].state) {
+    return;
+  }
+
+  auto &state = s_chunks[index];
+  state.state = State::PENDING;
+  state.field.clear();
+  Jobs::Run([index] { GenerateField(s_seed, s_params, index, s_chunks[index].field); },
+            &state.generating);
+}
+
+bool IsResident(Chunk chunk) { return State::RESIDENT == s_chunks[Index(chunk)].state; }
+
+void Take(Chunk chunk, std::vector<Meteor> &out) {
+  Prefetch(chunk);
+  auto &state = s_chunks[Index(chunk)];
+  WaitForField(state);
+
+  out.insert(out.end(), state.meteors.begin(), state.meteors.end());
+  state.meteors.clear();
+  state.state = State::RESIDENT;
+}
+
+bool Store(Chunk chunk, const Meteor &meteor) {
+  auto &state = s_chunks[Index(chunk)];
+  // A field still to come needs its room too
+  const size_t field =
+      State::EMPTY == state.state || State::PENDING == state.state ? s_params.max_per_chunk : 0;
+  if (state.meteors.size() + field >= RecordCapacity(s_params)) {
+    return false;
+  }
+  state.meteors.push_back(meteor);
+  return true;
+}
+
+void Evict(Chunk chunk) {
+  auto &state = s_chunks[Index(chunk)];
+  if (State::RESIDENT == state.state) {
+    state.state = State::READY;
+  }
+}
+
+size_t StoredMeteors() {
+  size_t count = 0;
+  for (const auto &chunk : s_chunks) {
+    count += chunk.meteors.size();
+  }
+  return count;
+}
+
+} // namespace World
@@ -0,0 +1,97 @@
+#ifndef WORLD_H
+#define WORLD_H
+
+// The game world: CHUNKS_X x CHUNKS_Y chunks of CHUNK_SIZE pixels, many screens wide. Every
+// chunk's meteor field is generated by a job (see jobs.hpp) from the level seed and its
+// coordinates, so a seed always gives the same world whatever order the chunks load in.
+//
+// Only the chunks around the ship live in the Registry. The others hold their meteors as Meteor
+// records: fields not yet visited as generated, evicted ones as they were left, mined meteors
+// stay mined.
+//
+//   World::Generate(seed, params);   // level load, drops every chunk
+//   World::Prefetch(chunk);          // generation ahead of the ship, does not block
+//   World::Take(chunk, meteors);     // the chunk's records, the caller spawns them
+//   World::Store(chunk, meteor);     // a meteor leaving the simulation, unless the chunk is full
+//
+// Every buffer is reserved by Generate: streaming does not allocate.
+//   World::Evict(chunk);             // once its meteors are stored
+
+#include "meteor-shapes.hpp"
+#include "raylib.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace World {
+
+constexpr float CHUNK_SIZE = 400.f;
+constexpr int CHUNKS_X = 24;
+constexpr int CHUNKS_Y = 24;
+constexpr Vector2 SIZE{CHUNKS_X * CHUNK_SIZE, CHUNKS_Y * CHUNK_SIZE};
+
+struct Chunk {
+  int x;
+  int y;
+};
+
+// A meteor outside the simulation
+struct Meteor {
+  Vector2 position;
+  Vector2 velocity;
+  float radius; // also its health, 0 when only its revealed core is left
+  MeteorShapes::Handle profile;
+};
+
+// What a level's fields are generated from
+struct Params {
+  int min_per_chunk;
+  int max_per_chunk; // in the densest parts of a field
+  int min_size;
+  int max_size;
+  float min_velocity;
+  float max_velocity;
+  Vector2 clear_center; // no meteor is generated closer than clear_radius, i.e the ship's start
+  float clear_radius;
+};
+
+// Records a chunk holds at most, its generated field included
+inline size_t RecordCapacity(const Params &params) {
+  return 2 * static_cast<size_t>(params.max_per_chunk);
+}
+
+// Drops every chunk and record, generation of the previous level is discarded
+void Generate(uint64_t seed, const Params &params);
+
+// Waits for the fields being generated and drops them
+void Shutdown();
+
+// Chunk containing `position`, clamped to the world
+Chunk ChunkAt(Vector2 position);
+
+// Within `radius` chunks of `center` on both axes
+inline bool InRange(Chunk chunk, Chunk center, int radius) {
+  return chunk.x >= center.x - radius && chunk.x <= center.x + radius &&
+         chunk.y >= center.y - radius && chunk.y <= center.y + radius;
+}
+
+void Prefetch(Chunk chunk);
+
+bool IsResident(Chunk chunk);
+
+// Appends the chunk's records to `out` and marks it resident. Waits when its generation has not
+// finished, which keeps streaming deterministic for replays; Prefetch makes that rare.
+void Take(Chunk chunk, std::vector<Meteor> &out);
+
+// Kept with `chunk` until it is taken. False when the chunk is full: the meteor stays simulated.
+bool Store(Chunk chunk, const Meteor &meteor);
+
+// No longer resident, its meteors must have been stored
+void Evict(Chunk chunk);
+
+// Records outside the simulation, generated or stored
+size_t StoredMeteors();
+
+} // namespace World
+
+#endif